@@ -22,7 +22,10 @@ namespace fin
     struct IBody : IComponent
     {
         Vec2f _previous_position;
-        Vec2f _speed;
+        Vec2f _speed;         // preferred velocity
+        Vec2f _velocity;      // velocity after local avoidance
+        float _radius{8};
+        float _max_speed{60};
 
         inline static std::string_view CID = "bdy";
     };
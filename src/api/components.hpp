@@ -53,6 +53,8 @@ namespace fin
         virtual ~IScriptComponent()          = default;
         virtual void Init(Entity entity)     = 0; // Initialize the component for the given entity
         virtual void Update(float deltaTime) = 0; // Update the component logic
+        virtual void OnEnterView() {};            // Entity entered the active region of its layer
+        virtual void OnLeaveView() {};            // Entity left the active region of its layer
     };
 
 
@@ -65,6 +67,7 @@ namespace fin
         ComponentsFlags  flags   = 0;       // flags for the component
         SparseSet*       storage = nullptr; // owned only if not external
         PluginHandle     owner   = nullptr; // owner plugin of the component
+        uint32_t         revision = 0;      // bumped whenever an entity gains or loses the component
 
         [[nodiscard]] IComponent* Get(const Entity ent) const
         {
@@ -81,14 +84,16 @@ namespace fin
             return storage->contains(ent);
         }
 
-        void Emplace(Entity ent) const
+        void Emplace(Entity ent)
         {
             storage->emplace(ent);
+            ++revision;
         }
 
-        void Erase(Entity ent) const
+        void Erase(Entity ent)
         {
             storage->erase(ent);
+            ++revision;
         }
 
         void OnSerialize(ArchiveParams& ar)
@@ -150,6 +155,7 @@ namespace fin
         }
         static T& Emplace(Entity ent)
         {
+            ++info->revision;
             if constexpr (std::is_constructible_v<T>)
             {
                 // If T is Interface, use set->emplace
@@ -165,6 +171,7 @@ namespace fin
         static void Erase(Entity ent)
         {
             static_cast<entt::storage<T>*>(set)->erase(ent);
+            ++info->revision;
         }
     };
 
@@ -51,10 +51,10 @@ namespace fin
         virtual void             Clear()                       = 0;
         virtual void             Init()                        = 0;
         virtual void             Deinit()                      = 0;
-        virtual void             Activate(const Rectf& region) = 0;
+        virtual void             Activate(const Rectf& region) = 0; // runs on a worker thread, next to other layers
         virtual void             Update(float dt)              = 0;
         virtual void             FixedUpdate(float dt)         = 0;
-        virtual void             Render(Renderer& dc)          = 0;
+        virtual void             Render(Renderer& dc)          = 0; // records on a worker thread, next to other layers
         virtual ObjectLayer*     Objects()                     = 0;
     };
 
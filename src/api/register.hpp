@@ -92,6 +92,7 @@ namespace fin
             if (component->storage->contains(entt))
             {
                 component->storage->remove(entt);
+                ++component->revision;
             }
         }
         return Release(entt, version);
@@ -100,6 +101,7 @@ namespace fin
     inline void Register::Emplace(const Entity entt, ComponentId cmp)
     {
         _components[cmp]->storage->emplace(entt);
+        ++_components[cmp]->revision;
     }
 
     inline void* Register::Get(const Entity entt, ComponentId cmp)
@@ -114,7 +116,8 @@ namespace fin
 
     inline void Register::Remove(const Entity entt, ComponentId cmp)
     {
-        _components[cmp]->storage->remove(entt);
+        if (_components[cmp]->storage->remove(entt))
+            ++_components[cmp]->revision;
     }
 
     inline void Register::AddComponentInfo(ComponentInfo* info)
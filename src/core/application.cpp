@@ -4,6 +4,7 @@
 #include "utils/imguiline.hpp"
 #include "editor/imgui_control.hpp"
 #include "ecs/builtin.hpp"
+#include "software_backend.hpp"
 #include "imgui_internal.h"
 
 #if defined(PLATFORM_DESKTOP) && defined(GRAPHICS_API_OPENGL_ES3)
@@ -289,9 +290,29 @@ namespace fin
         ImGui::PopStyleVar();
     }
 
+    bool Application::WriteThumbnail(std::string_view path)
+    {
+        constexpr int32_t ThumbnailSize = 512;
+
+        SoftwareBackend target;
+        Surface         out;
+        _map.RenderThumbnail(target, {ThumbnailSize, ThumbnailSize});
+        if (!target.read(out) || !ExportImage(*out.get_surface(), std::string(path).c_str()))
+        {
+            TraceLog(LOG_ERROR, "THUMBNAIL: failed to write %s", std::string(path).c_str());
+            return false;
+        }
+        TraceLog(LOG_INFO, "THUMBNAIL: %s", std::string(path).c_str());
+        return true;
+    }
+
     bool Application::OnIterate()
     {
         _map.Init();
+
+        // /thumbnail=<png> writes the scene given by /scene rendered on the CPU and exits
+        if (auto path = CmdAttributeGet("/thumbnail"); !path.empty())
+            return WriteThumbnail(path);
         while (!WindowShouldClose())
         {
             // Update
@@ -38,6 +38,7 @@ namespace fin
 
     private:
         void Imgui();
+        bool WriteThumbnail(std::string_view path);
         void ImguiInit(bool dark_theme);
         void ImguiFileMenu();
         void InitApi();
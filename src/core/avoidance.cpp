@@ -0,0 +1,217 @@
+#include "avoidance.hpp"
+
+namespace fin
+{
+    constexpr float AvoidanceEpsilon = 0.00001f;
+
+    // Half plane of permitted velocities, left of direction through point
+    struct OrcaLine
+    {
+        Vec2f point;
+        Vec2f direction;
+    };
+
+    // Optimizes along lines[lineNo] subject to all previous lines and the speed circle
+    static bool linearProgram1(const OrcaLine* lines, int32_t lineNo, float radius, Vec2f optVelocity, bool directionOpt, Vec2f& result)
+    {
+        const OrcaLine& line         = lines[lineNo];
+        const float     dotProduct   = line.point.dot(line.direction);
+        const float     discriminant = dotProduct * dotProduct + radius * radius - line.point.length_squared();
+
+        if (discriminant < 0.0f)
+            return false; // speed circle fully invalidates this line
+
+        const float sqrtDiscriminant = std::sqrt(discriminant);
+        float       tLeft            = -dotProduct - sqrtDiscriminant;
+        float       tRight           = -dotProduct + sqrtDiscriminant;
+
+        for (int32_t i = 0; i < lineNo; ++i)
+        {
+            const float denominator = line.direction.cross(lines[i].direction);
+            const float numerator   = lines[i].direction.cross(line.point - lines[i].point);
+
+            if (std::abs(denominator) <= AvoidanceEpsilon)
+            {
+                // Lines are parallel
+                if (numerator < 0.0f)
+                    return false;
+                continue;
+            }
+
+            const float t = numerator / denominator;
+            if (denominator >= 0.0f)
+                tRight = std::min(tRight, t);
+            else
+                tLeft = std::max(tLeft, t);
+
+            if (tLeft > tRight)
+                return false;
+        }
+
+        if (directionOpt)
+        {
+            result = line.point + line.direction * (optVelocity.dot(line.direction) > 0.0f ? tRight : tLeft);
+        }
+        else
+        {
+            const float t = std::clamp(line.direction.dot(optVelocity - line.point), tLeft, tRight);
+            result        = line.point + line.direction * t;
+        }
+        return true;
+    }
+
+    // Returns the index of the first line that failed, or count on success
+    static int32_t linearProgram2(const OrcaLine* lines, int32_t count, float radius, Vec2f optVelocity, bool directionOpt, Vec2f& result)
+    {
+        if (directionOpt)
+            result = optVelocity * radius;
+        else if (optVelocity.length_squared() > radius * radius)
+            result = optVelocity.normalized() * radius;
+        else
+            result = optVelocity;
+
+        for (int32_t i = 0; i < count; ++i)
+        {
+            if (lines[i].direction.cross(lines[i].point - result) > 0.0f)
+            {
+                const Vec2f tempResult = result;
+                if (!linearProgram1(lines, i, radius, optVelocity, directionOpt, result))
+                {
+                    result = tempResult;
+                    return i;
+                }
+            }
+        }
+        return count;
+    }
+
+    // Infeasible case, minimizes the maximum penetration into the failed half planes
+    static void linearProgram3(const OrcaLine* lines, int32_t count, int32_t beginLine, float radius, Vec2f& result)
+    {
+        OrcaLine projLines[Avoidance::MaxNeighbors];
+        float    distance = 0.0f;
+
+        for (int32_t i = beginLine; i < count; ++i)
+        {
+            if (lines[i].direction.cross(lines[i].point - result) <= distance)
+                continue;
+
+            int32_t projCount = 0;
+            for (int32_t j = 0; j < i; ++j)
+            {
+                OrcaLine    line;
+                const float determinant = lines[i].direction.cross(lines[j].direction);
+
+                if (std::abs(determinant) <= AvoidanceEpsilon)
+                {
+                    if (lines[i].direction.dot(lines[j].direction) > 0.0f)
+                        continue; // same direction
+                    line.point = (lines[i].point + lines[j].point) * 0.5f;
+                }
+                else
+                {
+                    line.point = lines[i].point +
+                                 lines[i].direction * (lines[j].direction.cross(lines[i].point - lines[j].point) / determinant);
+                }
+
+                line.direction         = (lines[j].direction - lines[i].direction).normalized();
+                projLines[projCount++] = line;
+            }
+
+            const Vec2f tempResult = result;
+            const Vec2f optDir(-lines[i].direction.y, lines[i].direction.x);
+            if (linearProgram2(projLines, projCount, radius, optDir, true, result) < projCount)
+                result = tempResult; // should not happen, keep the previous result on rounding errors
+
+            distance = lines[i].direction.cross(lines[i].point - result);
+        }
+    }
+
+    Vec2f Avoidance::computeVelocity(const AvoidanceAgent&           self,
+                                     Vec2f                           preferred,
+                                     float                           maxSpeed,
+                                     std::span<const AvoidanceAgent> neighbors,
+                                     float                           timeHorizon,
+                                     float                           dt)
+    {
+        OrcaLine     lines[MaxNeighbors];
+        int32_t      count          = 0;
+        const float  invTimeHorizon = 1.0f / timeHorizon;
+        const float  invTimeStep    = 1.0f / std::max(dt, AvoidanceEpsilon);
+        const size_t limit          = std::min<size_t>(neighbors.size(), MaxNeighbors);
+
+        for (size_t n = 0; n < limit; ++n)
+        {
+            const AvoidanceAgent& other            = neighbors[n];
+            const Vec2f           relativePosition = other.position - self.position;
+            const Vec2f           relativeVelocity = self.velocity - other.velocity;
+            const float           distSq           = relativePosition.length_squared();
+            const float           combinedRadius   = self.radius + other.radius;
+            const float           combinedRadiusSq = combinedRadius * combinedRadius;
+
+            OrcaLine line;
+            Vec2f    u;
+
+            if (distSq > combinedRadiusSq)
+            {
+                // No collision yet, vector from cutoff center to relative velocity
+                const Vec2f w           = relativeVelocity - relativePosition * invTimeHorizon;
+                const float wLengthSq   = w.length_squared();
+                const float dotProduct1 = w.dot(relativePosition);
+
+                if (dotProduct1 < 0.0f && dotProduct1 * dotProduct1 > combinedRadiusSq * wLengthSq)
+                {
+                    // Project on cut-off circle
+                    const float wLength = std::sqrt(wLengthSq);
+                    const Vec2f unitW   = w / wLength;
+
+                    line.direction = Vec2f(unitW.y, -unitW.x);
+                    u              = unitW * (combinedRadius * invTimeHorizon - wLength);
+                }
+                else
+                {
+                    // Project on legs
+                    const float leg = std::sqrt(distSq - combinedRadiusSq);
+
+                    if (relativePosition.cross(w) > 0.0f)
+                    {
+                        line.direction = Vec2f(relativePosition.x * leg - relativePosition.y * combinedRadius,
+                                               relativePosition.x * combinedRadius + relativePosition.y * leg) /
+                                         distSq;
+                    }
+                    else
+                    {
+                        line.direction = -Vec2f(relativePosition.x * leg + relativePosition.y * combinedRadius,
+                                                -relativePosition.x * combinedRadius + relativePosition.y * leg) /
+                                         distSq;
+                    }
+
+                    u = line.direction * relativeVelocity.dot(line.direction) - relativeVelocity;
+                }
+            }
+            else
+            {
+                // Already overlapping, project on cut-off circle of this time step
+                const Vec2f w       = relativeVelocity - relativePosition * invTimeStep;
+                const float wLength = w.length();
+                if (wLength <= AvoidanceEpsilon)
+                    continue; // coincident agents with equal velocity, no side to pick
+
+                const Vec2f unitW = w / wLength;
+                line.direction    = Vec2f(unitW.y, -unitW.x);
+                u                 = unitW * (combinedRadius * invTimeStep - wLength);
+            }
+
+            line.point     = self.velocity + u * 0.5f;
+            lines[count++] = line;
+        }
+
+        Vec2f         result;
+        const int32_t lineFail = linearProgram2(lines, count, maxSpeed, preferred, false, result);
+        if (lineFail < count)
+            linearProgram3(lines, count, lineFail, maxSpeed, result);
+
+        return result;
+    }
+
+} // namespace fin
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "include.hpp"
+
+namespace fin
+{
+    /// @brief Circular agent as seen by the avoidance solver.
+    struct AvoidanceAgent
+    {
+        Vec2f position;
+        Vec2f velocity;
+        float radius = 0;
+    };
+
+    /// @brief Optimal reciprocal collision avoidance (ORCA).
+    /// Picks the velocity closest to the preferred one that stays collision free
+    /// for timeHorizon seconds, assuming every neighbour takes half of the effort.
+    /// The solver is stateless and allocation free, so agents can be solved in parallel.
+    struct Avoidance
+    {
+        static constexpr int32_t MaxNeighbors = 16;
+
+        static Vec2f computeVelocity(const AvoidanceAgent&           self,
+                                     Vec2f                           preferred,
+                                     float                           maxSpeed,
+                                     std::span<const AvoidanceAgent> neighbors,
+                                     float                           timeHorizon,
+                                     float                           dt);
+    };
+
+} // namespace fin
@@ -381,8 +381,10 @@ namespace fin
 
     bool CBody::OnDeserialize(ArchiveParams& ar)
     {
-        _speed.x = ar.data["vx"].get(0.f);
-        _speed.y = ar.data["vy"].get(0.f);
+        _speed.x   = ar.data["vx"].get(0.f);
+        _speed.y   = ar.data["vy"].get(0.f);
+        _radius    = ar.data["r"].get(8.f);
+        _max_speed = ar.data["ms"].get(60.f);
         return true;
     }
 
@@ -390,11 +392,15 @@ namespace fin
     {
         ar.data.set_item("vx", _speed.x);
         ar.data.set_item("vy", _speed.y);
+        ar.data.set_item("r", _radius);
+        ar.data.set_item("ms", _max_speed);
     }
 
     bool CBody::OnEdit(Entity ent)
     {
         auto r = ImGui::InputFloat2("Speed", &_speed.x);
+        r |= ImGui::InputFloat("Radius", &_radius);
+        r |= ImGui::InputFloat("Max speed", &_max_speed);
         return r;
     }
 
@@ -480,6 +486,7 @@ namespace fin
             el._sprite = ref;
             el._offset = off;
             _bbox.x1   = FLT_MIN;
+            Sprite2D::Invalidate();
             return n;
         }
         return -1;
@@ -491,6 +498,7 @@ namespace fin
             return;
         _items[idx] = {};
         _bbox.x1    = FLT_MIN;
+        Sprite2D::Invalidate();
     }
 
     void CAttachment::MoveTo(int idx, Vec2f off)
@@ -499,6 +507,7 @@ namespace fin
             return;
         _items[idx]._offset = off;
         _bbox.x1            = FLT_MIN;
+        Sprite2D::Invalidate();
     }
 
     void CAttachment::Clear()
@@ -506,6 +515,7 @@ namespace fin
         for (auto& el : _items)
             el = {};
         _bbox = {};
+        Sprite2D::Invalidate();
     }
 
     Region<float> CAttachment::GetBoundingBox() const
@@ -572,6 +582,7 @@ namespace fin
                     _items[n]._offset.y = el["y"].get(0.f);
                 }
             }
+            Sprite2D::Invalidate();
         }
         return true;
     }
@@ -589,7 +600,10 @@ namespace fin
             ImGui::Separator();
         }
         if (ret)
+        {
             _bbox.x1 = FLT_MIN;
+            Sprite2D::Invalidate();
+        }
         return ret;
     }
 
@@ -628,6 +642,7 @@ namespace fin
         _spr = Sprite2D::LoadShared(ar.data.get_item("src").str());
         _origin.x = ar.data.get_item("x").get(0.f);
         _origin.y = ar.data.get_item("y").get(0.f);
+        Sprite2D::Invalidate();
         return !!_spr;
     }
 
@@ -636,6 +651,8 @@ namespace fin
         bool ret{};
         ret |= ImGui::SpriteInput("Sprite", &_spr);
         ret |= ImGui::InputFloat2("Offset", &_origin.x);
+        if (ret)
+            Sprite2D::Invalidate();
         return ret;
     }
 
@@ -671,6 +688,7 @@ namespace fin
             _origin.x = -org.x;
             _origin.y = -org.y;
             ret       = true;
+            Sprite2D::Invalidate();
         }
 
         return ret;
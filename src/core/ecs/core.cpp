@@ -2,6 +2,8 @@
 #include "builtin.hpp"
 #include "core/scene.hpp"
 #include "core/scene_layer_object.hpp"
+#include "core/avoidance.hpp"
+#include "utils/thread_pool.hpp"
 
 
 namespace fin::ecs
@@ -67,9 +69,48 @@ namespace fin::ecs
             delta       = target_pos - pos;
         }
 
-        Vec2f dir        = delta.normalized();
-        float move_speed = 60.0f; // or body->max_speed
-        body._speed     = dir * move_speed;
+        body._speed = delta.normalized() * body._max_speed;
+    }
+
+    // Nearest bodies around base within range, sorted by distance
+    inline size_t gather_neighbors(const lq::SpatialDatabase& spatial, const CBase& base, float range, AvoidanceAgent* neighbors)
+    {
+        float  distance[Avoidance::MaxNeighbors];
+        size_t count = 0;
+
+        auto cb = [&](lq::SpatialDatabase::Proxy* proxy, float dist_sq)
+        {
+            const CBase* other = static_cast<const CBase*>(proxy);
+            if (other == &base)
+                return;
+
+            const CBody* other_body = Find<CBody>(other->_self);
+            if (!other_body)
+                return;
+
+            size_t at = count;
+            if (count == Avoidance::MaxNeighbors)
+            {
+                if (dist_sq >= distance[count - 1])
+                    return;
+                --at; // replace the farthest
+            }
+            else
+            {
+                ++count;
+            }
+
+            for (; at > 0 && distance[at - 1] > dist_sq; --at)
+            {
+                distance[at]  = distance[at - 1];
+                neighbors[at] = neighbors[at - 1];
+            }
+            distance[at]  = dist_sq;
+            neighbors[at] = {other->_position, other_body->_velocity, other_body->_radius};
+        };
+
+        spatial.map_over_all_objects_in_locality(base._position.x, base._position.y, range, cb);
+        return count;
     }
 
     void Navigation::update_objects(float dt, ObjectSceneLayer* layer)
@@ -78,8 +119,12 @@ namespace fin::ecs
         auto&      registry = factory.GetRegister();
         const auto view     = View<CBase, CBody>();
         auto&      navmesh  = layer->GetNavmesh();
+        auto&      spatial  = layer->GetSpatialDatabase();
         auto&      objects  = layer->GetObjects(true);
 
+        // Preferred velocities
+        float max_radius = 0;
+        _agents.clear();
         for (auto ent : objects)
         {
             if (!registry.Valid(ent) || !view.Contains(ent))
@@ -93,7 +138,47 @@ namespace fin::ecs
                 update_path(base, body, Get<CPath>(ent), navmesh);
             }
 
-            if (body._speed == Vec2f())
+            if (body._speed == Vec2f() && body._velocity == Vec2f())
+            {
+                continue;
+            }
+
+            _agents.push_back({&base, &body, body._velocity});
+            max_radius = std::max(max_radius, body._radius);
+        }
+
+        // Local avoidance, agents only read shared state so the batch runs in parallel
+        ThreadPool::Get().parallel_for(int32_t(_agents.size()),
+                                       64,
+                                       [&](int32_t begin, int32_t end)
+                                       {
+                                           AvoidanceAgent neighbors[Avoidance::MaxNeighbors];
+                                           for (int32_t n = begin; n < end; ++n)
+                                           {
+                                               Agent&      agent     = _agents[n];
+                                               CBase&      base      = *agent.base;
+                                               CBody&      body      = *agent.body;
+                                               const float max_speed = std::max(body._max_speed, body._speed.length());
+                                               const float range = max_speed * _time_horizon + body._radius + max_radius;
+                                               const auto  count = gather_neighbors(spatial, base, range, neighbors);
+
+                                               agent.velocity = Avoidance::computeVelocity({base._position, body._velocity, body._radius},
+                                                                                           body._speed,
+                                                                                           max_speed,
+                                                                                           {neighbors, count},
+                                                                                           _time_horizon,
+                                                                                           dt);
+                                           }
+                                       });
+
+        // Integration against the navmesh
+        for (auto& agent : _agents)
+        {
+            CBase& base = *agent.base;
+            CBody& body = *agent.body;
+
+            body._velocity = agent.velocity;
+            if (body._velocity == Vec2f())
             {
                 continue;
             }
@@ -101,7 +186,7 @@ namespace fin::ecs
             body._previous_position = base._position;
 
             Vec2f from = base._position;
-            Vec2f to   = from + body._speed * dt;
+            Vec2f to   = from + body._velocity * dt;
 
             Vec2i grid_from = navmesh.worldToCell(from);
             Vec2i grid_to   = navmesh.worldToCell(to);
@@ -135,6 +220,7 @@ namespace fin::ecs
                 }
             }
             base._position = result;
+            base.UpdateSparseGrid();
         }
     }
 
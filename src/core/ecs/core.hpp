@@ -5,6 +5,8 @@
 namespace fin
 {
     class ObjectSceneLayer;
+    struct CBase;
+    struct CBody;
 }
 
 namespace fin::ecs
@@ -21,6 +23,17 @@ namespace fin::ecs
         void Update(float dt) override;
         void update_objects(float dt, ObjectSceneLayer* layer);
         bool ImguiSetup() override;
+
+    private:
+        struct Agent
+        {
+            CBase* base;
+            CBody* body;
+            Vec2f  velocity;
+        };
+
+        std::vector<Agent> _agents;
+        float              _time_horizon{1.f};
     };
 
 
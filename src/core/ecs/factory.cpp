@@ -187,6 +187,11 @@ namespace fin
             return; // If the entity is null, we cannot load it
         }
 
+        LoadEntityData(entity, data);
+    }
+
+    void ComponentFactory::LoadEntityData(Entity entity, msg::Var& data)
+    {
         auto uid = data[Sc::Uid];
         auto cls = data[Sc::Class];
 
@@ -235,28 +240,40 @@ namespace fin
         }
     }
 
-    void ComponentFactory::OnLayerUpdate(float dt, SparseSet& active)
+    void ComponentFactory::OnLayerUpdate(float dt, std::span<const ActiveScript> scripts)
     {
-        for (auto* comp : _registry.GetComponents())
+        for (auto& script : scripts)
         {
-            if (!(comp->flags & ComponentsFlags_Script))
-                continue;
-
-            SparseSet* smallset = &active;
-            SparseSet* bigset   = comp->storage;
-            if (bigset->size() < smallset->size())
-                std::swap(smallset, bigset);
-
-            for (auto ent : *smallset)
+            // A script may remove components of other entities during its update
+            if (script.info->storage->contains(script.entity))
             {
-                if (bigset->contains(ent))
-                {
-                    static_cast<IScriptComponent*>(comp->storage->get(ent))->Update(dt);
-                }
+                static_cast<IScriptComponent*>(script.info->storage->get(script.entity))->Update(dt);
             }
         }
     }
 
+    void ComponentFactory::CollectScripts(Entity entity, std::vector<ActiveScript>& out)
+    {
+        for (auto* comp : _registry.GetComponents())
+        {
+            if ((comp->flags & ComponentsFlags_Script) && comp->storage->contains(entity))
+                out.push_back({comp, entity});
+        }
+    }
+
+    uint64_t ComponentFactory::GetScriptSignature()
+    {
+        // Revisions only grow, so the sum changes whenever a script component is added to or removed
+        // from any entity, even when another entity gains the same type in the same frame
+        uint64_t sig = 0;
+        for (auto* comp : _registry.GetComponents())
+        {
+            if (comp->flags & ComponentsFlags_Script)
+                sig += uint64_t(comp->revision) + 1;
+        }
+        return sig;
+    }
+
     bool ComponentFactory::IsPrefabMode() const
     {
         return _prefab_explorer;
@@ -13,6 +13,13 @@ namespace ImGui
 namespace fin
 {
     class Scene;
+
+    struct ActiveScript
+    {
+        ComponentInfo* info;
+        Entity         entity;
+    };
+
     class ComponentFactory
     {
         friend class ImportDialog;
@@ -38,9 +45,12 @@ namespace fin
         bool Save();
 
         void LoadEntity(Entity& entity, msg::Var& ar);
+        void LoadEntityData(Entity entity, msg::Var& ar);
         void SaveEntity(Entity entity, msg::Var& ar);
 
-        void OnLayerUpdate(float dt, SparseSet& active);
+        void     OnLayerUpdate(float dt, std::span<const ActiveScript> scripts);
+        void     CollectScripts(Entity entity, std::vector<ActiveScript>& out);
+        uint64_t GetScriptSignature();
         bool IsPrefabMode() const;
 
         bool             SetEntityName(Entity entity, std::string_view name);
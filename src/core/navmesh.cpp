@@ -1,4 +1,5 @@
 #include "navmesh.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace fin
 {
@@ -9,6 +10,12 @@ namespace fin
         return 1.0f * (dx + dy) + (1.4142f - 2) * std::min(dx, dy);
     }
 
+    // Bits [from, to] of a 64 bit word, 0 <= from <= to < 64
+    inline uint64_t spanMask(int from, int to)
+    {
+        return (~uint64_t(0) >> (63 - to)) & (~uint64_t(0) << from);
+    }
+
 
     Navmesh::Navmesh(float worldWidth, float worldHeight, int gridCellWidth, int gridCellHeight) :
     cell(gridCellWidth, gridCellHeight)
@@ -27,8 +34,12 @@ namespace fin
         size       = {worldWidth, worldHeight};
         cellsize.x = static_cast<int>(std::ceil(worldWidth / cell.x));
         cellsize.y = static_cast<int>(std::ceil(worldHeight / cell.y));
+        rowWords   = (cellsize.x + 63) / 64;
         terrain.resize(cellsize.x * cellsize.y);
+        blockers.resize(cellsize.x * cellsize.y);
+        rebuildBlocked();
         changed = true;
+        ++version;
     }
 
     Vec2i Navmesh::worldToCell(Vec2f pos) const
@@ -53,9 +64,58 @@ namespace fin
 
     bool Navmesh::isWalkable(int x, int y) const
     {
-        if (x < 0 || y < 0 || x >= cellsize.x || y >= cellsize.y)
+        if (uint32_t(x) >= uint32_t(cellsize.x) || uint32_t(y) >= uint32_t(cellsize.y))
             return false;
-        return !(terrain[y * cellsize.x + x] & TERRAIN_BLOCKED);
+        return !((blocked[y * rowWords + (x >> 6)] >> (x & 63)) & 1);
+    }
+
+    bool Navmesh::isSpanWalkable(int row, int fromCol, int toCol) const
+    {
+        const uint64_t* line = &blocked[row * rowWords];
+        const int       w0   = fromCol >> 6;
+        const int       w1   = toCol >> 6;
+
+        if (w0 == w1)
+            return !(line[w0] & spanMask(fromCol & 63, toCol & 63));
+
+        if (line[w0] & spanMask(fromCol & 63, 63))
+            return false;
+        for (int w = w0 + 1; w < w1; ++w)
+        {
+            if (line[w])
+                return false;
+        }
+        return !(line[w1] & spanMask(0, toCol & 63));
+    }
+
+    void Navmesh::setBlocked(int row, int fromCol, int toCol, bool value)
+    {
+        uint64_t* line = &blocked[row * rowWords];
+        const int w0   = fromCol >> 6;
+        const int w1   = toCol >> 6;
+
+        for (int w = w0; w <= w1; ++w)
+        {
+            const uint64_t mask = spanMask(w == w0 ? fromCol & 63 : 0, w == w1 ? toCol & 63 : 63);
+            if (value)
+                line[w] |= mask;
+            else
+                line[w] &= ~mask;
+        }
+    }
+
+    void Navmesh::rebuildBlocked()
+    {
+        blocked.assign(size_t(rowWords) * cellsize.y, 0);
+        for (int y = 0; y < cellsize.y; ++y)
+        {
+            const uint8_t* line = &terrain[y * cellsize.x];
+            for (int x = 0; x < cellsize.x; ++x)
+            {
+                if (line[x] & TERRAIN_BLOCKED)
+                    blocked[y * rowWords + (x >> 6)] |= uint64_t(1) << (x & 63);
+            }
+        }
     }
 
     float Navmesh::cost(int x, int y) const
@@ -141,69 +201,119 @@ namespace fin
         if (path.size() < 3)
             return;
 
-        std::vector<Vec2i> optimized;
-        optimized.push_back(path.front());
-
+        // Compacts in place, kept points never overtake the read position
+        size_t writeIdx = 1;
         size_t startIdx = 0;
-        size_t nextIdx  = 1;
 
-        while (nextIdx < path.size())
+        while (startIdx + 1 < path.size())
         {
             // Try to extend line of sight as far as possible
-            size_t farthest = nextIdx;
-            for (size_t i = nextIdx + 1; i < path.size(); ++i)
+            size_t farthest = startIdx + 1;
+            for (size_t i = farthest + 1; i < path.size(); ++i)
             {
                 if (!lineOfSight(path[startIdx], path[i]))
                     break;
                 farthest = i;
             }
 
-            optimized.push_back(path[farthest]);
-            startIdx = farthest;
-            nextIdx  = startIdx + 1;
+            path[writeIdx++] = path[farthest];
+            startIdx         = farthest;
         }
 
-        path = std::move(optimized);
+        path.resize(writeIdx);
     }
-    // Returns true if the line from 'start' to 'end' is walkable (no obstacles)
+
+    // Returns true if the segment between cell centers crosses no blocked cell.
+    // Walks the segment row by row and tests the covered column span a word at a time.
     bool Navmesh::lineOfSight(const Vec2i& start, const Vec2i& end) const
     {
-        int x0 = start.x, y0 = start.y;
-        int x1 = end.x, y1 = end.y;
+        if (!isWalkable(start.x, start.y) || !isWalkable(end.x, end.y))
+            return false;
 
-        int dx = std::abs(x1 - x0);
-        int dy = std::abs(y1 - y0);
+        const int minX = std::min(start.x, end.x);
+        const int maxX = std::max(start.x, end.x);
 
-        int sx = (x0 < x1) ? 1 : -1;
-        int sy = (y0 < y1) ? 1 : -1;
+        if (start.y == end.y)
+            return isSpanWalkable(start.y, minX, maxX);
 
-        int err = dx - dy;
+        const float x0   = start.x + 0.5f;
+        const float y0   = start.y + 0.5f;
+        const float y1   = end.y + 0.5f;
+        const float dxdy = float(end.x - start.x) / float(end.y - start.y);
+        const float minY = std::min(y0, y1);
+        const float maxY = std::max(y0, y1);
+        const int   last = std::max(start.y, end.y);
 
-        while (true)
+        for (int row = std::min(start.y, end.y); row <= last; ++row)
         {
-            if (!isWalkable(x0, y0))
+            float xa = x0 + (std::max(float(row), minY) - y0) * dxdy;
+            float xb = x0 + (std::min(float(row + 1), maxY) - y0) * dxdy;
+            if (xa > xb)
+                std::swap(xa, xb);
+
+            const int fromCol = std::max(minX, static_cast<int>(std::floor(xa)));
+            const int toCol   = std::clamp(static_cast<int>(std::ceil(xb)) - 1, fromCol, maxX);
+
+            if (!isSpanWalkable(row, fromCol, toCol))
                 return false;
+        }
 
-            if (x0 == x1 && y0 == y1)
-                break;
+        return true;
+    }
+
+    bool Navmesh::findPath(Vec2i start, Vec2i end, std::vector<Vec2i>& outPath) const
+    {
+        if (pathCacheSize == 0)
+            return searchPath(start, end, outPath);
 
-            int e2 = 2 * err;
-            if (e2 > -dy)
+        const PathKey key{start, end};
+        {
+            std::lock_guard lock(pathLock);
+            if (pathCacheVersion != version)
             {
-                err -= dy;
-                x0 += sx;
+                // Terrain changed, every cached route may be stale
+                pathCache.clear();
+                pathLookup.clear();
+                pathCacheVersion = version;
             }
-            if (e2 < dx)
+
+            if (auto it = pathLookup.find(key); it != pathLookup.end())
             {
-                err += dx;
-                y0 += sy;
+                ++pathStats.hits;
+                pathCache.splice(pathCache.begin(), pathCache, it->second);
+                outPath = it->second->path;
+                return it->second->found;
             }
+            ++pathStats.misses;
         }
 
-        return true;
+        // Searched without the lock, a route found by another thread meanwhile is kept
+        const bool found = searchPath(start, end, outPath);
+
+        std::lock_guard lock(pathLock);
+        if (pathCacheVersion != version || pathLookup.contains(key))
+            return found;
+
+        if (pathCache.size() >= pathCacheSize)
+        {
+            // Recycle the least recently used entry
+            pathLookup.erase(pathCache.back().key);
+            pathCache.splice(pathCache.begin(), pathCache, std::prev(pathCache.end()));
+        }
+        else
+        {
+            pathCache.emplace_front();
+        }
+
+        auto& entry = pathCache.front();
+        entry.key   = key;
+        entry.found = found;
+        entry.path  = outPath;
+        pathLookup.emplace(key, pathCache.begin());
+        return found;
     }
 
-    bool Navmesh::findPath(Vec2i start, Vec2i end, std::vector<Vec2i>& outPath) const
+    bool Navmesh::searchPath(Vec2i start, Vec2i end, std::vector<Vec2i>& outPath) const
     {
         static constexpr int dx[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
         static constexpr int dy[8] = {0, 0, -1, 1, -1, 1, -1, 1};
@@ -227,8 +337,10 @@ namespace fin
         startNode.x     = start.x;
         startNode.y     = start.y;
         startNode.gCost = 0;
-        startNode.fCost = heuristic(start, end);
-        startNode.open  = true;
+        startNode.fCost   = heuristic(start, end);
+        startNode.parentX = -1;
+        startNode.parentY = -1;
+        startNode.open    = true;
 
         auto cmp = [&](const Vec2i& a, const Vec2i& b) { return nodes[a].fCost > nodes[b].fCost; };
 
@@ -257,6 +369,7 @@ namespace fin
             {
                 reconstructPath(current, nodes, outPath);
                 refinePath(outPath);
+                raycastOptimize(outPath);
                 return true;
             }
 
@@ -296,18 +409,19 @@ namespace fin
         {
             reconstructPath(nodes[best], nodes, outPath);
             refinePath(outPath);
+            raycastOptimize(outPath);
             return true;
         }
 
         return false;
     }
 
-    void Navmesh::applyTerrain(const std::vector<Vec2f>& poly, uint8_t flag, bool add)
+    template <typename CB>
+    static void rasterizePolygon(const std::vector<Vec2f>& poly, Vec2i cell, Vec2i cellsize, CB cb)
     {
         if (poly.size() < 3)
             return;
 
-        changed    = true;
         float minY = poly[0].y, maxY = poly[0].y;
         for (const auto& p : poly)
         {
@@ -315,13 +429,14 @@ namespace fin
             maxY = std::max(maxY, p.y);
         }
 
-        int minRow = static_cast<int>(minY / cell.y);
-        int maxRow = static_cast<int>(maxY / cell.y);
+        int minRow = std::max(static_cast<int>(minY / cell.y), 0);
+        int maxRow = std::min(static_cast<int>(maxY / cell.y), cellsize.y - 1);
 
+        std::vector<float> nodesX;
         for (int row = minRow; row <= maxRow; ++row)
         {
-            float              scanY = row * cell.y + 0.5f * cell.y;
-            std::vector<float> nodesX;
+            float scanY = row * cell.y + 0.5f * cell.y;
+            nodesX.clear();
 
             for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++)
             {
@@ -336,26 +451,245 @@ namespace fin
             std::sort(nodesX.begin(), nodesX.end());
             for (size_t i = 0; i + 1 < nodesX.size(); i += 2)
             {
-                int startCol = static_cast<int>(nodesX[i] / cell.x);
-                int endCol   = static_cast<int>(nodesX[i + 1] / cell.x);
-                for (int col = startCol; col <= endCol; ++col)
+                int startCol = std::max(static_cast<int>(nodesX[i] / cell.x), 0);
+                int endCol   = std::min(static_cast<int>(nodesX[i + 1] / cell.x), cellsize.x - 1);
+                if (startCol <= endCol)
+                    cb(row, startCol, endCol);
+            }
+        }
+    }
+
+    void Navmesh::applyTerrain(const std::vector<Vec2f>& poly, uint8_t flag, bool add)
+    {
+        if (poly.size() < 3)
+            return;
+
+        // Blocking is counted per cell so it stacks with obstacles, clearing only drops this polygon's count
+        if (flag & TERRAIN_BLOCKED)
+        {
+            applyObstacle(poly, add);
+            flag &= uint8_t(~TERRAIN_BLOCKED);
+            if (!flag)
+                return;
+        }
+
+        changed = true;
+        ++version;
+        rasterizePolygon(poly,
+                         cell,
+                         cellsize,
+                         [&](int row, int startCol, int endCol)
+                         {
+                             uint8_t* line = &terrain[row * cellsize.x];
+                             for (int col = startCol; col <= endCol; ++col)
+                             {
+                                 if (add)
+                                     line[col] |= flag;
+                                 else
+                                     line[col] &= ~flag;
+                             }
+                         });
+    }
+
+    void Navmesh::applyObstacle(const std::vector<Vec2f>& poly, bool add)
+    {
+        if (poly.size() < 3)
+            return;
+
+        bool toggled = false;
+        rasterizePolygon(poly,
+                         cell,
+                         cellsize,
+                         [&](int row, int startCol, int endCol)
+                         {
+                             const int offset = row * cellsize.x;
+                             for (int col = startCol; col <= endCol; ++col)
+                             {
+                                 if (add)
+                                 {
+                                     if (addBlocker(offset + col))
+                                     {
+                                         terrain[offset + col] |= TERRAIN_BLOCKED;
+                                         setBlocked(row, col, col, true);
+                                         toggled = true;
+                                     }
+                                 }
+                                 else if (removeBlocker(offset + col))
+                                 {
+                                     terrain[offset + col] &= ~TERRAIN_BLOCKED;
+                                     setBlocked(row, col, col, false);
+                                     toggled = true;
+                                 }
+                             }
+                         });
+
+        if (toggled)
+        {
+            // Only walkability changes invalidate cached paths
+            changed = true;
+            ++version;
+        }
+    }
+
+    void Navmesh::applyObstacles(std::span<const std::vector<Vec2f>* const> polys, bool add)
+    {
+        if (polys.empty() || cellsize.x <= 0 || cellsize.y <= 0)
+            return;
+
+        changed = true;
+        ++version;
+
+        // Visits every scanline crossing of every edge, same rule and math as rasterizePolygon
+        auto for_each_crossing = [&](auto cb)
+        {
+            for (uint32_t n = 0; n < polys.size(); ++n)
+            {
+                const auto& poly = *polys[n];
+                if (poly.size() < 3)
+                    continue;
+
+                for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++)
                 {
-                    if (col >= 0 && col < cellsize.x && row >= 0 && row < cellsize.y)
+                    Vec2f p1 = poly[i], p2 = poly[j];
+                    if (p1.y == p2.y)
+                        continue;
+
+                    const int firstRow = std::max(static_cast<int>(std::min(p1.y, p2.y) / cell.y), 0);
+                    const int lastRow  = std::min(static_cast<int>(std::max(p1.y, p2.y) / cell.y), cellsize.y - 1);
+                    for (int row = firstRow; row <= lastRow; ++row)
                     {
-                        uint8_t& cell = terrain[row * cellsize.x + col];
-                        if (add)
-                            cell |= flag;
-                        else
-                            cell &= ~flag;
+                        float scanY = row * cell.y + 0.5f * cell.y;
+                        if ((p1.y <= scanY && p2.y > scanY) || (p2.y <= scanY && p1.y > scanY))
+                            cb(row, n, p1.x + (scanY - p1.y) * (p2.x - p1.x) / (p2.y - p1.y));
                     }
                 }
             }
+        };
+
+        // Bin crossings by row with a counting sort
+        rowStart.assign(cellsize.y + 1, 0);
+        for_each_crossing([&](int row, uint32_t, float) { ++rowStart[row + 1]; });
+        for (int row = 0; row < cellsize.y; ++row)
+            rowStart[row + 1] += rowStart[row];
+
+        crossings.resize(rowStart.back());
+        std::vector<uint32_t> fill(rowStart.begin(), rowStart.end() - 1);
+        for_each_crossing([&](int row, uint32_t poly, float x) { crossings[fill[row]++] = {poly, x}; });
+
+        // Rows are independent, fill them in parallel
+        ThreadPool::Get().parallel_for(
+            cellsize.y,
+            16,
+            [&](int32_t from, int32_t to)
+            {
+                for (int32_t row = from; row < to; ++row)
+                {
+                    auto* first = crossings.data() + rowStart[row];
+                    auto* last  = crossings.data() + rowStart[row + 1];
+                    if (first == last)
+                        continue;
+
+                    std::sort(first,
+                              last,
+                              [](const Crossing& a, const Crossing& b)
+                              { return a.poly < b.poly || (a.poly == b.poly && a.x < b.x); });
+
+                    const int offset = row * cellsize.x;
+                    while (first != last)
+                    {
+                        auto* group = first;
+                        while (group != last && group->poly == first->poly)
+                            ++group;
+
+                        for (auto* it = first; it + 1 < group; it += 2)
+                        {
+                            int startCol = std::max(static_cast<int>(it[0].x / cell.x), 0);
+                            int endCol   = std::min(static_cast<int>(it[1].x / cell.x), cellsize.x - 1);
+                            for (int col = startCol; col <= endCol; ++col)
+                            {
+                                if (add)
+                                {
+                                    if (addBlocker(offset + col))
+                                    {
+                                        terrain[offset + col] |= TERRAIN_BLOCKED;
+                                        setBlocked(row, col, col, true);
+                                    }
+                                }
+                                else if (removeBlocker(offset + col))
+                                {
+                                    terrain[offset + col] &= ~TERRAIN_BLOCKED;
+                                    setBlocked(row, col, col, false);
+                                }
+                            }
+                        }
+                        first = group;
+                    }
+                }
+            });
+    }
+
+    bool Navmesh::addBlocker(int index)
+    {
+        // Rows are filled in parallel, a cell is only touched by its own row but the overflow is shared
+        uint8_t& count = blockers[index];
+        if (count == UINT8_MAX)
+        {
+            std::lock_guard lock(overflowLock);
+            ++blockerOverflow[uint32_t(index)];
+            return false;
         }
+        return count++ == 0;
+    }
+
+    bool Navmesh::removeBlocker(int index)
+    {
+        uint8_t& count = blockers[index];
+        if (count == UINT8_MAX)
+        {
+            std::lock_guard lock(overflowLock);
+            auto it = blockerOverflow.find(uint32_t(index));
+            if (it != blockerOverflow.end())
+            {
+                if (--it->second == 0)
+                    blockerOverflow.erase(it);
+                return false;
+            }
+        }
+        return count && --count == 0;
     }
 
     void Navmesh::resetTerrain()
     {
         std::fill(terrain.begin(), terrain.end(), 0);
+        std::fill(blockers.begin(), blockers.end(), 0);
+        blockerOverflow.clear();
+        std::fill(blocked.begin(), blocked.end(), 0);
+        changed = true;
+        ++version;
+    }
+
+    uint32_t Navmesh::terrainVersion() const
+    {
+        return version;
+    }
+
+    void Navmesh::setPathCacheSize(size_t count)
+    {
+        pathCacheSize = count;
+        clearPathCache();
+    }
+
+    void Navmesh::clearPathCache()
+    {
+        std::lock_guard lock(pathLock);
+        pathCache.clear();
+        pathLookup.clear();
+    }
+
+    Navmesh::PathCacheStats Navmesh::pathCacheStats() const
+    {
+        std::lock_guard lock(pathLock);
+        return pathStats;
     }
 
     const Texture& Navmesh::getDebugTexture() const
@@ -3,6 +3,9 @@
 #include "include.hpp"
 #include "shared_resource.hpp"
 
+#include <list>
+#include <mutex>
+
 namespace fin
 {
     enum TerrainFlags : uint8_t
@@ -15,6 +18,37 @@ namespace fin
 
     class Navmesh
     {
+        struct Crossing
+        {
+            uint32_t poly;
+            float    x;
+        };
+
+        struct PathKey
+        {
+            Vec2i start;
+            Vec2i end;
+
+            bool operator==(const PathKey&) const = default;
+        };
+
+        struct PathKeyHash
+        {
+            size_t operator()(const PathKey& k) const noexcept
+            {
+                const uint64_t a = (uint64_t(uint32_t(k.start.x)) << 32) | uint32_t(k.start.y);
+                const uint64_t b = (uint64_t(uint32_t(k.end.x)) << 32) | uint32_t(k.end.y);
+                return std::hash<uint64_t>{}(a ^ (b * 0x9e3779b97f4a7c15ull));
+            }
+        };
+
+        struct CachedPath
+        {
+            PathKey            key;
+            bool               found;
+            std::vector<Vec2i> path;
+        };
+
         struct Node
         {
             int   x = 0, y = 0;
@@ -25,6 +59,12 @@ namespace fin
         };
 
     public:
+        struct PathCacheStats
+        {
+            uint64_t hits{};
+            uint64_t misses{};
+        };
+
         Navmesh(float worldWidth, float worldHeight, int gridCellWidth, int gridCellHeight);
         ~Navmesh();
 
@@ -37,23 +77,53 @@ namespace fin
         Vec2f          cellToWorld(Vec2i cell) const;
         Vec2f          worldSize() const;
         Vec2i          cellSize() const;
-        void           applyTerrain(const std::vector<Vec2f>& poly, uint8_t flag, bool add);
+        void           applyTerrain(const std::vector<Vec2f>& poly, uint8_t flag, bool add); // TERRAIN_BLOCKED as applyObstacle
+        void           applyObstacle(const std::vector<Vec2f>& poly, bool add); // reference counted TERRAIN_BLOCKED
+        void           applyObstacles(std::span<const std::vector<Vec2f>* const> polys, bool add);
         void           resetTerrain();
         const Texture& getDebugTexture() const;
+        uint32_t       terrainVersion() const;
+
+        void           setPathCacheSize(size_t count);
+        void           clearPathCache();
+        PathCacheStats pathCacheStats() const;
 
     private:
+        bool  searchPath(Vec2i start, Vec2i end, std::vector<Vec2i>& outPath) const;
         float cost(int x, int y) const;
         void  reconstructPath(const Vec2i&                           endPos,
                               const std::unordered_map<Vec2i, Node>& nodes,
                               std::vector<Vec2i>&                    outPath) const;
         void  refinePath(std::vector<Vec2i>& path) const;
         void  raycastOptimize(std::vector<Vec2i>& path) const;
+        bool  isSpanWalkable(int row, int fromCol, int toCol) const;
+        void  setBlocked(int row, int fromCol, int toCol, bool value);
+        bool  addBlocker(int index);
+        bool  removeBlocker(int index);
+        void  rebuildBlocked();
+
+        using PathCache = std::list<CachedPath>;
+
+        std::vector<uint8_t>  terrain;
+        std::vector<uint8_t>  blockers; // obstacles covering each cell, saturates into blockerOverflow
+        std::unordered_map<uint32_t, uint32_t> blockerOverflow; // cells with more than 255 obstacles, count above 255
+        std::mutex                             overflowLock;
+        std::vector<uint64_t> blocked;  // TERRAIN_BLOCKED bit plane, row-major, 64 cells per word
+        int32_t               rowWords{};
+        std::vector<uint32_t> rowStart;  // scratch for applyObstacles, crossings per row
+        std::vector<Crossing> crossings; // scratch for applyObstacles, binned by row
+        Vec2f                 size;
+        Vec2i                 cell;
+        Vec2i                 cellsize;
+        uint32_t              version{}; // bumped whenever walkability or cost changes
+        size_t                pathCacheSize{256};
 
-        std::vector<uint8_t> terrain;
-        Vec2f                size;
-        Vec2i                cell;
-        Vec2i                cellsize;
-        mutable bool         changed{};
-        mutable Texture      debug{};
+        mutable std::mutex                                                     pathLock; // findPath may run on several threads
+        mutable PathCache                                                      pathCache; // most recent first
+        mutable std::unordered_map<PathKey, PathCache::iterator, PathKeyHash> pathLookup;
+        mutable uint32_t                                                       pathCacheVersion{};
+        mutable PathCacheStats                                                 pathStats;
+        mutable bool                                             changed{};
+        mutable Texture                                          debug{};
     };
 } // namespace fin
@@ -23,54 +23,37 @@ namespace fin
 
     void Renderer::render_texture(const Texture* texture, const Rectf& source, const Rectf& dest)
     {
-        const auto width  = texture->width;
-        const auto height = texture->height;
+        const float inv_w = 1.f / texture->width;
+        const float inv_h = 1.f / texture->height;
 
-
-        rlBegin(RL_QUADS);
-
-        rlSetTexture(texture->id);
-        rlColor4ub(_color.r, _color.g, _color.b, _color.a);
-        rlNormal3f(0.0f, 0.0f, 1.0f); // Normal vector pointing towards viewer
-
-        // Top-left corner for texture and quad
-        rlTexCoord2f(source.x / width, source.y / height);
-        rlVertex2f(dest.x, dest.y);
-
-        // Bottom-left corner for texture and quad
-        rlTexCoord2f(source.x / width, (source.y + source.height) / height);
-        rlVertex2f(dest.x, dest.y2());
-
-        // Bottom-right corner for texture and quad
-        rlTexCoord2f((source.x + source.width) / width, (source.y + source.height) / height);
-        rlVertex2f(dest.x2(), dest.y2());
-
-        // Top-right corner for texture and quad
-        rlTexCoord2f((source.x + source.width) / width, source.y / height);
-        rlVertex2f(dest.x2(), dest.y);
-
-        rlEnd();
-        rlSetTexture(0);
+        _commands.add_quad(texture->id,
+                           dest,
+                           {source.x * inv_w, source.y * inv_h, source.x2() * inv_w, source.y2() * inv_h},
+                           _color);
     }
 
     void Renderer::render_line(Vec2f from, Vec2f to)
     {
-        DrawLine(from.x, from.y, to.x, to.y, _color);
+        _commands.add_line(from, to, _color);
     }
 
     void Renderer::render_line(float fromx, float fromy, float tox, float toy)
     {
-        DrawLine(fromx, fromy, tox, toy, _color);
+        _commands.add_line({fromx, fromy}, {tox, toy}, _color);
     }
 
     void Renderer::render_line_rect(const Rectf& dest)
     {
-        DrawRectangleLinesEx({dest.x, dest.y, dest.width, dest.height}, 1, _color);
+        const Vec2f a(dest.x, dest.y), b(dest.x2(), dest.y), c(dest.x2(), dest.y2()), d(dest.x, dest.y2());
+        _commands.add_line(a, b, _color);
+        _commands.add_line(b, c, _color);
+        _commands.add_line(c, d, _color);
+        _commands.add_line(d, a, _color);
     }
 
     void Renderer::render_rect(const Rectf& dest)
     {
-        DrawRectangleV({dest.x, dest.y}, {dest.width, dest.height}, _color);
+        _commands.add_quad(0, dest, {0, 0, 1, 1}, _color);
     }
 
     void Renderer::render_polyline(const Vec2f* point, size_t size, bool closed, Vec2f offset)
@@ -80,86 +63,470 @@ namespace fin
 
         for (size_t n = 0; n < size - 1; ++n)
         {
-            auto from = point[n] + offset;
-            auto to   = point[n + 1] + offset;
-            DrawLine(from.x, from.y, to.x, to.y, _color);
+            _commands.add_line(point[n] + offset, point[n + 1] + offset, _color);
         }
 
         if (closed)
         {
-            auto from = point[0] + offset;
-            auto to   = point[size - 1] + offset;
-            DrawLine(from.x, from.y, to.x, to.y, _color);
+            _commands.add_line(point[0] + offset, point[size - 1] + offset, _color);
         }
-
     }
 
     void Renderer::render_triangle(Vec2f a, Vec2f b, Vec2f c)
     {
-        Color color = {_color.r, _color.g, _color.b, _color.a};
-        DrawTriangle({a.x, a.y}, {b.x, b.y}, {c.x, c.y}, color);
+        _commands.add_triangle(0, a, b, c, _color);
     }
 
     void Renderer::render_line_circle(Vec2f pos, float radius)
     {
-        DrawCircleLinesV({pos.x, pos.y}, radius, _color);
+        constexpr int32_t segments = 36;
+        for (int32_t n = 0; n < segments; ++n)
+        {
+            const float a0 = n * (2 * PI / segments);
+            const float a1 = (n + 1) * (2 * PI / segments);
+            _commands.add_line({pos.x + std::cos(a0) * radius, pos.y + std::sin(a0) * radius},
+                               {pos.x + std::cos(a1) * radius, pos.y + std::sin(a1) * radius},
+                               _color);
+        }
     }
 
     void Renderer::render_circle(Vec2f pos, float radius)
     {
-        DrawCircleV({pos.x, pos.y}, radius, _color);
+        constexpr int32_t segments = 36;
+        for (int32_t n = 0; n < segments; ++n)
+        {
+            const float a0 = n * (2 * PI / segments);
+            const float a1 = (n + 1) * (2 * PI / segments);
+            _commands.add_triangle(0,
+                                   pos,
+                                   {pos.x + std::cos(a1) * radius, pos.y + std::sin(a1) * radius},
+                                   {pos.x + std::cos(a0) * radius, pos.y + std::sin(a0) * radius},
+                                   _color);
+        }
     }
 
     void Renderer::render_debug_text(Vec2f to, const char* fmt, ...)
     {
-        static char buf[512];
+        // On the stack, renderers of one layer record on several threads at once
+        char buf[512];
 
         va_list args;
         va_start(args, fmt);
         int w = vsnprintf(buf, std::size(buf), fmt, args);
         va_end(args);
 
-        if (w == -1 || w >= (int)std::size(buf))
+        if (w < 0)
+            w = 0;
+        else if (w >= (int)std::size(buf))
             w = (int)std::size(buf) - 1;
         buf[w] = 0;
 
-        DrawText(buf, to.x, to.y, 10, _color);
+        _commands.add_text(to, {buf, size_t(w)}, _color);
     }
 
-    void Renderer::SetShader(Shader2D* txt)
+    void Renderer::render_geometry(GeometryBuffer& buffer, const StaticGeometry& geo, const Rectf& view)
     {
-        Shader2D::Bind(txt);
+        if (!geo.empty())
+            _commands.add_geometry(buffer, geo, view, _color);
     }
 
-    void Renderer::RenderTexture(const Texture2D* txt, const Regionf& pos, const Regionf& uv)
+    void Renderer::flush()
     {
-        if (!txt)
+        if (_commands.empty())
+            return;
+
+        (_backend ? _backend : &RlglBackend::Get())->submit(_commands);
+        _draw_calls += uint32_t(_commands.commands().size());
+        _commands.clear();
+    }
+
+    void Renderer::inherit(const Renderer& parent)
+    {
+        _debug  = parent._debug;
+        _color  = parent._color;
+        _camera = parent._camera;
+    }
+
+    void Renderer::append(Renderer& part)
+    {
+        _commands.append(part._commands);
+        part._commands.clear();
+    }
+
+    void Renderer::set_backend(RenderBackend* backend)
+    {
+        flush();
+        _backend = backend;
+    }
+
+    RenderBackend* Renderer::get_backend() const
+    {
+        return _backend;
+    }
+
+    CommandList& Renderer::get_commands()
+    {
+        return _commands;
+    }
+
+    uint32_t Renderer::draw_calls() const
+    {
+        return _draw_calls;
+    }
+
+    void Renderer::reset_stats()
+    {
+        _draw_calls = 0;
+    }
+
+    void CommandList::clear()
+    {
+        _commands.clear();
+        _vertices.clear();
+        _texts.clear();
+        _chars.clear();
+        _geometry.clear();
+        _shaders.clear();
+    }
+
+    bool CommandList::empty() const
+    {
+        return _commands.empty();
+    }
+
+    GeometryVertex* CommandList::push(RenderOp op, uint32_t texture, uint32_t count)
+    {
+        const uint32_t first = uint32_t(_vertices.size());
+        if (_commands.empty() || _commands.back().op != op || _commands.back().texture != texture ||
+            _commands.back().count + count > MaxVertices)
+        {
+            _commands.push_back({op, texture, first, 0});
+        }
+        _commands.back().count += count;
+        _vertices.resize(first + count);
+        return &_vertices[first];
+    }
+
+    void CommandList::add_quad(uint32_t texture, const Regionf& dest, const Regionf& uv, Color color)
+    {
+        auto* v = push(RenderOp::Quads, texture, 4);
+        v[0]    = {dest.x1, dest.y1, uv.x1, uv.y1, color.r, color.g, color.b, color.a};
+        v[1]    = {dest.x1, dest.y2, uv.x1, uv.y2, color.r, color.g, color.b, color.a};
+        v[2]    = {dest.x2, dest.y2, uv.x2, uv.y2, color.r, color.g, color.b, color.a};
+        v[3]    = {dest.x2, dest.y1, uv.x2, uv.y1, color.r, color.g, color.b, color.a};
+    }
+
+    void CommandList::add_line(Vec2f from, Vec2f to, Color color)
+    {
+        auto* v = push(RenderOp::Lines, 0, 2);
+        v[0]    = {from.x, from.y, 0, 0, color.r, color.g, color.b, color.a};
+        v[1]    = {to.x, to.y, 0, 0, color.r, color.g, color.b, color.a};
+    }
+
+    void CommandList::add_triangle(uint32_t texture, Vec2f a, Vec2f b, Vec2f c, Color color)
+    {
+        auto* v = push(RenderOp::Triangles, texture, 3);
+        v[0]    = {a.x, a.y, 0, 0, color.r, color.g, color.b, color.a};
+        v[1]    = {b.x, b.y, 0, 0, color.r, color.g, color.b, color.a};
+        v[2]    = {c.x, c.y, 0, 0, color.r, color.g, color.b, color.a};
+    }
+
+    void CommandList::add_text(Vec2f pos, std::string_view text, Color color)
+    {
+        _commands.push_back({RenderOp::Text, 0, uint32_t(_texts.size()), 0});
+        _texts.push_back({pos, color, uint32_t(_chars.size())});
+        _chars.insert(_chars.end(), text.begin(), text.end());
+        _chars.push_back(0);
+    }
+
+    void CommandList::add_geometry(GeometryBuffer& buffer, const StaticGeometry& geo, const Rectf& view, Color color)
+    {
+        _commands.push_back({RenderOp::Geometry, 0, uint32_t(_geometry.size()), 0});
+        _geometry.push_back({&buffer, &geo, view, color});
+    }
+
+    void CommandList::set_shader(Shader2D* shader)
+    {
+        _commands.push_back({RenderOp::Shader, 0, uint32_t(_shaders.size()), 0});
+        _shaders.push_back(shader);
+    }
+
+    void CommandList::append(const CommandList& other)
+    {
+        const uint32_t vertices = uint32_t(_vertices.size());
+        const uint32_t texts    = uint32_t(_texts.size());
+        const uint32_t chars    = uint32_t(_chars.size());
+        const uint32_t geometry = uint32_t(_geometry.size());
+        const uint32_t shaders  = uint32_t(_shaders.size());
+
+        _vertices.insert(_vertices.end(), other._vertices.begin(), other._vertices.end());
+        _chars.insert(_chars.end(), other._chars.begin(), other._chars.end());
+        _geometry.insert(_geometry.end(), other._geometry.begin(), other._geometry.end());
+        _shaders.insert(_shaders.end(), other._shaders.begin(), other._shaders.end());
+        for (auto txt : other._texts)
+        {
+            txt.offset += chars;
+            _texts.push_back(txt);
+        }
+
+        for (auto cmd : other._commands)
+        {
+            switch (cmd.op)
+            {
+            case RenderOp::Quads:
+            case RenderOp::Lines:
+            case RenderOp::Triangles:
+                cmd.first += vertices;
+                // Vertices of both lists are contiguous, the first command may continue our last one
+                if (!_commands.empty() && _commands.back().op == cmd.op && _commands.back().texture == cmd.texture &&
+                    _commands.back().first + _commands.back().count == cmd.first && _commands.back().count + cmd.count <= MaxVertices)
+                {
+                    _commands.back().count += cmd.count;
+                    continue;
+                }
+                break;
+            case RenderOp::Text:
+                cmd.first += texts;
+                break;
+            case RenderOp::Geometry:
+                cmd.first += geometry;
+                break;
+            case RenderOp::Shader:
+                cmd.first += shaders;
+                break;
+            }
+            _commands.push_back(cmd);
+        }
+    }
+
+    std::span<const RenderCommand> CommandList::commands() const
+    {
+        return _commands;
+    }
+
+    std::span<const GeometryVertex> CommandList::vertices() const
+    {
+        return _vertices;
+    }
+
+    const CommandList::Text& CommandList::text(uint32_t n) const
+    {
+        return _texts[n];
+    }
+
+    const char* CommandList::text_string(const Text& txt) const
+    {
+        return _chars.data() + txt.offset;
+    }
+
+    const CommandList::Geometry& CommandList::geometry(uint32_t n) const
+    {
+        return _geometry[n];
+    }
+
+    Shader2D* CommandList::shader(uint32_t n) const
+    {
+        return _shaders[n];
+    }
+
+    RlglBackend& RlglBackend::Get()
+    {
+        static RlglBackend backend;
+        return backend;
+    }
+
+    void RlglBackend::submit(const CommandList& list)
+    {
+        const auto vertices = list.vertices();
+        for (auto& cmd : list.commands())
+        {
+            switch (cmd.op)
+            {
+            case RenderOp::Quads:
+            case RenderOp::Triangles:
+            case RenderOp::Lines:
+            {
+                const int mode = cmd.op == RenderOp::Quads ? RL_QUADS : cmd.op == RenderOp::Lines ? RL_LINES : RL_TRIANGLES;
+                rlCheckRenderBatchLimit(int(cmd.count));
+                if (cmd.op != RenderOp::Lines)
+                    rlSetTexture(cmd.texture ? cmd.texture : rlGetTextureIdDefault());
+                rlBegin(mode);
+                rlNormal3f(0.0f, 0.0f, 1.0f); // Normal vector pointing towards viewer
+                for (auto& v : vertices.subspan(cmd.first, cmd.count))
+                {
+                    rlColor4ub(v.r, v.g, v.b, v.a);
+                    rlTexCoord2f(v.u, v.v);
+                    rlVertex2f(v.x, v.y);
+                }
+                rlEnd();
+                rlSetTexture(0);
+                break;
+            }
+            case RenderOp::Text:
+            {
+                auto& txt = list.text(cmd.first);
+                DrawText(list.text_string(txt), int(txt.pos.x), int(txt.pos.y), 10, txt.color);
+                break;
+            }
+            case RenderOp::Geometry:
+                draw_geometry(list.geometry(cmd.first));
+                break;
+            case RenderOp::Shader:
+                Shader2D::Bind(list.shader(cmd.first));
+                break;
+            }
+        }
+    }
+
+    void RlglBackend::draw_geometry(const CommandList::Geometry& cmd)
+    {
+        auto&       buffer = *cmd.buffer;
+        const auto& geo    = *cmd.geometry;
+
+        buffer.upload(geo);
+        geo.query(cmd.view, buffer._visible);
+        if (buffer._visible.empty())
             return;
 
-        rlBegin(RL_QUADS);
+        rlDrawRenderBatchActive();
 
-        rlSetTexture(txt->get_texture()->id);
-        rlColor4ub(_color.r, _color.g, _color.b, _color.a);
-        rlNormal3f(0.0f, 0.0f, 1.0f); // Normal vector pointing towards viewer
+        const auto  shader = rlGetShaderIdDefault();
+        const auto* locs   = rlGetShaderLocsDefault();
+        const float tint[4]{cmd.color.r / 255.f, cmd.color.g / 255.f, cmd.color.b / 255.f, cmd.color.a / 255.f};
 
-        // Top-left corner for texture and quad
-        rlTexCoord2f(uv.x1, uv.y1);
-        rlVertex2f(pos.x1, pos.y1);
+        rlEnableShader(shader);
+        rlSetUniformMatrix(locs[RL_SHADER_LOC_MATRIX_MVP], MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+        rlSetUniform(locs[RL_SHADER_LOC_COLOR_DIFFUSE], tint, RL_SHADER_UNIFORM_VEC4, 1);
+        rlActiveTextureSlot(0);
+        rlDisableBackfaceCulling();
 
-        // Bottom-left corner for texture and quad
-        rlTexCoord2f(uv.x1, uv.y2);
-        rlVertex2f(pos.x1, pos.y2);
+        const auto* first = geo.chunks().data();
+        for (auto* chunk : buffer._visible)
+        {
+            auto& gpu = buffer._chunks[chunk - first];
+            if (!rlEnableVertexArray(gpu._vao))
+                continue;
+
+            for (auto& batch : chunk->batches)
+            {
+                rlEnableTexture(batch.texture);
+                rlDrawVertexArrayElements(batch.first, batch.count, nullptr);
+            }
+        }
 
-        // Bottom-right corner for texture and quad
-        rlTexCoord2f(uv.x2, uv.y2);
-        rlVertex2f(pos.x2, pos.y2);
+        rlDisableVertexArray();
+        rlDisableTexture();
+        rlEnableBackfaceCulling();
+        rlDisableShader();
+    }
 
-        // Top-right corner for texture and quad
-        rlTexCoord2f(uv.x2, uv.y1);
-        rlVertex2f(pos.x2, pos.y1);
+    RecordingBackend::RecordingBackend(bool keep_commands) : _keep(keep_commands)
+    {
+    }
 
-        rlEnd();
-        rlSetTexture(0);
+    void RecordingBackend::submit(const CommandList& list)
+    {
+        for (auto& cmd : list.commands())
+        {
+            switch (cmd.op)
+            {
+            case RenderOp::Quads:
+                _stats.quads += cmd.count / 4;
+                break;
+            case RenderOp::Lines:
+                _stats.lines += cmd.count / 2;
+                break;
+            case RenderOp::Triangles:
+                _stats.triangles += cmd.count / 3;
+                break;
+            case RenderOp::Text:
+                ++_stats.texts;
+                break;
+            case RenderOp::Geometry:
+                ++_stats.geometry;
+                break;
+            case RenderOp::Shader:
+                ++_stats.shaders;
+                continue;
+            }
+            ++_stats.draw_calls;
+        }
+
+        if (_keep)
+            _commands.insert(_commands.end(), list.commands().begin(), list.commands().end());
+    }
+
+    void RecordingBackend::reset()
+    {
+        _stats = {};
+        _commands.clear();
+    }
+
+    const RecordingBackend::Stats& RecordingBackend::stats() const
+    {
+        return _stats;
+    }
+
+    std::span<const RenderCommand> RecordingBackend::commands() const
+    {
+        return _commands;
+    }
+
+    GeometryBuffer::~GeometryBuffer()
+    {
+        release();
+    }
+
+    void GeometryBuffer::upload(const StaticGeometry& geo)
+    {
+        if (_revision == geo.revision())
+            return;
+
+        release();
+        _revision = geo.revision();
+        for (auto& chunk : geo.chunks())
+        {
+            auto& gpu = _chunks.emplace_back();
+            gpu._vao  = rlLoadVertexArray();
+            rlEnableVertexArray(gpu._vao);
+
+            gpu._vbo = rlLoadVertexBuffer(chunk.vertices.data(), int(chunk.vertices.size() * sizeof(GeometryVertex)), false);
+            rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 2, RL_FLOAT, false, sizeof(GeometryVertex), offsetof(GeometryVertex, x));
+            rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+            rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, RL_FLOAT, false, sizeof(GeometryVertex), offsetof(GeometryVertex, u));
+            rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+            rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, sizeof(GeometryVertex), offsetof(GeometryVertex, r));
+            rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+
+            gpu._ebo = rlLoadVertexBufferElement(chunk.indices.data(), int(chunk.indices.size() * sizeof(uint16_t)), false);
+        }
+        rlDisableVertexArray();
+    }
+
+    void GeometryBuffer::release()
+    {
+        for (auto& gpu : _chunks)
+        {
+            rlUnloadVertexBuffer(gpu._vbo);
+            rlUnloadVertexBuffer(gpu._ebo);
+            rlUnloadVertexArray(gpu._vao);
+        }
+        _chunks.clear();
+        _visible.clear();
+        _revision = ~0u;
+    }
+
+    void Renderer::SetShader(Shader2D* txt)
+    {
+        _commands.set_shader(txt);
+    }
+
+    void Renderer::RenderTexture(const Texture2D* txt, const Regionf& pos, const Regionf& uv)
+    {
+        if (!txt)
+            return;
+
+        _commands.add_quad(txt->get_texture()->id, pos, uv, _color);
     }
 
     bool Renderer::is_debug() const
@@ -167,6 +534,4 @@ namespace fin
         return _debug;
     }
 
-   
-
 } // namespace fin
@@ -1,12 +1,159 @@
 #pragma once
 
 #include "include.hpp"
+#include "utils/static_geometry.hpp"
 
 namespace fin
 {
     class Texture2D;
     class Shader2D;
 
+    /// GPU copy of a StaticGeometry, one vertex array per chunk, uploaded again when the geometry is rebuilt.
+    class GeometryBuffer
+    {
+    public:
+        GeometryBuffer() = default;
+        ~GeometryBuffer();
+        GeometryBuffer(const GeometryBuffer&) = delete;
+
+        void upload(const StaticGeometry& geo);
+        void release();
+
+    private:
+        friend class RlglBackend;
+
+        struct Chunk
+        {
+            uint32_t _vao{};
+            uint32_t _vbo{};
+            uint32_t _ebo{};
+        };
+
+        std::vector<Chunk>                _chunks;
+        std::vector<const GeometryChunk*> _visible;
+        uint32_t                          _revision{~0u};
+    };
+
+    enum class RenderOp : uint8_t
+    {
+        Quads,     // 4 vertices per quad
+        Lines,     // 2 vertices per line
+        Triangles, // 3 vertices per triangle
+        Text,      // index into text commands
+        Geometry,  // index into geometry commands
+        Shader,    // index into shaders
+    };
+
+    struct RenderCommand
+    {
+        RenderOp op;
+        uint32_t texture; // quads and triangles, 0 is untextured
+        uint32_t first;   // first vertex, or item for Text, Geometry and Shader
+        uint32_t count;   // vertices
+    };
+
+    /// Compact list of draw commands in submission order.
+    /// Consecutive primitives of the same kind and texture merge into one command, so a command is one
+    /// draw call for the backend. Recording touches no GPU state and is safe without a GL context.
+    class CommandList
+    {
+    public:
+        struct Text
+        {
+            Vec2f    pos;
+            Color    color;
+            uint32_t offset; // in chars, zero terminated
+        };
+
+        struct Geometry
+        {
+            GeometryBuffer*       buffer;
+            const StaticGeometry* geometry;
+            Rectf                 view;
+            Color                 color;
+        };
+
+        void clear();
+        bool empty() const;
+
+        void add_quad(uint32_t texture, const Regionf& dest, const Regionf& uv, Color color);
+        void add_line(Vec2f from, Vec2f to, Color color);
+        void add_triangle(uint32_t texture, Vec2f a, Vec2f b, Vec2f c, Color color);
+        void add_text(Vec2f pos, std::string_view text, Color color);
+        void add_geometry(GeometryBuffer& buffer, const StaticGeometry& geo, const Rectf& view, Color color);
+        void set_shader(Shader2D* shader);
+        /// Adds the commands of other after these, merging the seam when possible.
+        void append(const CommandList& other);
+
+        std::span<const RenderCommand>  commands() const;
+        std::span<const GeometryVertex> vertices() const;
+        const Text&                     text(uint32_t n) const;
+        const char*                     text_string(const Text& txt) const;
+        const Geometry&                 geometry(uint32_t n) const;
+        Shader2D*                       shader(uint32_t n) const;
+
+    private:
+        static constexpr uint32_t MaxVertices = 4096 * 4; // per command, fits one rlgl batch
+
+        GeometryVertex* push(RenderOp op, uint32_t texture, uint32_t count);
+
+        std::vector<RenderCommand>  _commands;
+        std::vector<GeometryVertex> _vertices;
+        std::vector<Text>           _texts;
+        std::vector<char>           _chars;
+        std::vector<Geometry>       _geometry;
+        std::vector<Shader2D*>      _shaders;
+    };
+
+    /// Consumes command lists.
+    class RenderBackend
+    {
+    public:
+        virtual ~RenderBackend()                     = default;
+        virtual void submit(const CommandList& list) = 0;
+    };
+
+    /// Draws through rlgl, the backend of the game and the editor.
+    class RlglBackend : public RenderBackend
+    {
+    public:
+        static RlglBackend& Get();
+
+        void submit(const CommandList& list) override;
+
+    private:
+        void draw_geometry(const CommandList::Geometry& cmd);
+    };
+
+    /// Headless backend, counts what would be drawn and optionally keeps a copy of the commands.
+    class RecordingBackend : public RenderBackend
+    {
+    public:
+        struct Stats
+        {
+            uint32_t draw_calls{};
+            uint32_t quads{};
+            uint32_t lines{};
+            uint32_t triangles{};
+            uint32_t texts{};
+            uint32_t geometry{};
+            uint32_t shaders{};
+        };
+
+        explicit RecordingBackend(bool keep_commands = false);
+
+        void submit(const CommandList& list) override;
+        void reset();
+
+        const Stats&                   stats() const;
+        std::span<const RenderCommand> commands() const;
+
+    private:
+        Stats                      _stats;
+        std::vector<RenderCommand> _commands;
+        bool                       _keep{};
+    };
+
     class Renderer
     {
     public:
@@ -28,6 +175,20 @@ namespace fin
         void render_line_circle(Vec2f pos, float radius);
         void render_circle(Vec2f pos, float radius);
         void render_debug_text(Vec2f to, const char* fmt, ...);
+        void render_geometry(GeometryBuffer& buffer, const StaticGeometry& geo, const Rectf& view);
+        /// Submits recorded commands to the backend, call before drawing through raylib directly.
+        void flush();
+        /// Takes color, camera and debug flag of parent, for renderers recording on other threads.
+        void inherit(const Renderer& parent);
+        /// Moves the commands recorded by part to the end of this list.
+        void append(Renderer& part);
+
+        /// Backend receiving the commands, nullptr selects rlgl.
+        void           set_backend(RenderBackend* backend);
+        RenderBackend* get_backend() const;
+        CommandList&   get_commands();
+        uint32_t       draw_calls() const;
+        void           reset_stats();
 
         void SetShader(Shader2D* txt);
         void RenderTexture(const Texture2D* txt, const Regionf& pos, const Regionf& uv);
@@ -35,5 +196,10 @@ namespace fin
         bool     _debug{};
         Color    _color{WHITE};
         Camera2D _camera{{}, {}, 0, 1.f};
+
+    private:
+        CommandList    _commands;
+        RenderBackend* _backend{};
+        uint32_t       _draw_calls{};
     };
 }
@@ -6,6 +6,7 @@
 #include "ecs/core.hpp"
 #include <rlgl.h>
 #include "application.hpp"
+#include "software_backend.hpp"
 
 namespace fin
 {
@@ -413,6 +414,15 @@ namespace fin
         if (!_canvas)
             return;
 
+        //dc.set_origin({(float)_camera.position.x, (float)_camera.position.y});
+        dc._camera.target.x = _camera.position.x;
+        dc._camera.target.y = _camera.position.y;
+        dc._camera.zoom = _camera.zoom;
+        dc.reset_stats();
+
+        // Layers may draw into their own targets before the canvas is bound
+        GetLayers().PreRender(dc);
+
         // Draw on the canvas
         BeginTextureMode(*_canvas.get_texture());
         ClearBackground(_background);
@@ -420,19 +430,42 @@ namespace fin
         rlSetBlendFactorsSeparate(0x0302, 0x0303, 1, 0x0303, 0x8006, 0x8006);
         BeginBlendMode(BLEND_CUSTOM_SEPARATE);
 
-        //dc.set_origin({(float)_camera.position.x, (float)_camera.position.y});
-        dc._camera.target.x = _camera.position.x;
-        dc._camera.target.y = _camera.position.y;
-        dc._camera.zoom = _camera.zoom;
         BeginMode2D(dc._camera);
 
         GetLayers().Render(dc);
+        dc.flush();
 
         EndMode2D();
         EndTextureMode();
 
     }
 
+    void Scene::RenderThumbnail(SoftwareBackend& target, Vec2i size)
+    {
+        const float zoom = std::min(size.x / _size.x, size.y / _size.y);
+
+        Renderer dc;
+        dc._camera.target   = {0, 0};
+        dc._camera.offset   = {(size.x - _size.x * zoom) * 0.5f, (size.y - _size.y * zoom) * 0.5f};
+        dc._camera.rotation = 0;
+        dc._camera.zoom     = zoom;
+        dc.set_backend(&target);
+
+        target.begin(size.x, size.y, _background);
+        target.set_camera(dc._camera);
+        Texture2D::for_each_shared(
+            [&target](Texture2D& txt)
+            {
+                if (!target.has_texture(txt.get_texture()->id))
+                    target.set_texture(txt);
+            });
+
+        // PreRender is skipped, it draws into GPU targets the CPU copies would not see
+        GetLayers().Activate({0, 0, _size.x, _size.y});
+        GetLayers().Render(dc);
+        dc.flush();
+    }
+
     void Scene::Update(float dt)
     {
         if (_mode == SceneMode::Play)
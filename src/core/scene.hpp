@@ -12,6 +12,8 @@ namespace fin
 {
     constexpr int32_t SCENE_VERSION = 1;
 
+    class SoftwareBackend;
+
     struct Camera
     {
         Vec2f position;
@@ -57,6 +59,8 @@ namespace fin
         void Init();
         void Deinit();
         void Render(Renderer& dc);
+        /// Whole scene fit into size on the CPU. Layers stay activated over all of it until the next Update.
+        void RenderThumbnail(SoftwareBackend& target, Vec2i size);
         void Update(float dt);
         void PostUpdate(float dt);
         void FixedUpdate(float dt);
@@ -5,6 +5,7 @@
 #include "utils/lquadtree.hpp"
 #include "utils/lquery.hpp"
 #include "utils/imguiline.hpp"
+#include "utils/thread_pool.hpp"
 #include "editor/imgui_control.hpp"
 
 namespace fin
@@ -181,6 +182,10 @@ namespace fin
         _region = region;
     }
 
+    void SceneLayer::Stream(const Rectf& region)
+    {
+    }
+
     void SceneLayer::Update(float dt)
     {
     }
@@ -193,6 +198,10 @@ namespace fin
     {
     }
 
+    void SceneLayer::PreRender(Renderer& dc)
+    {
+    }
+
     ObjectLayer* SceneLayer::Objects()
     {
         return nullptr;
@@ -301,20 +310,52 @@ namespace fin
 
     void LayerManager::Activate(const Rectf& region)
     {
+        // Streaming creates and destroys entities, it runs before the layers go wide
         for (auto* ly : _layers)
         {
-            ly->Activate(region);
+            ly->Stream(region);
         }
+
+        // Layers only touch their own data while activating, so they are prepared side by side
+        // and everything is done before systems and rendering read them
+        ThreadPool::Get().parallel_for(int32_t(_layers.size()),
+                                       1,
+                                       [&](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t n = begin; n < end; ++n)
+                                               _layers[n]->Activate(region);
+                                       });
     }
 
-    void LayerManager::Render(Renderer& dc)
+    void LayerManager::PreRender(Renderer& dc)
     {
         for (auto* el : _layers)
         {
-            el->Render(dc);
+            el->PreRender(dc);
         }
     }
 
+    void LayerManager::Render(Renderer& dc)
+    {
+        // Layers record into their own lists on the pool, the lists are joined in layer order
+        while (_parts.size() < _layers.size())
+            _parts.push_back(std::make_unique<Renderer>());
+
+        for (size_t n = 0; n < _layers.size(); ++n)
+            _parts[n]->inherit(dc);
+
+        ThreadPool::Get().parallel_for(int32_t(_layers.size()),
+                                       1,
+                                       [&](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t n = begin; n < end; ++n)
+                                               _layers[n]->Render(*_parts[n]);
+                                       });
+
+        for (size_t n = 0; n < _layers.size(); ++n)
+            dc.append(*_parts[n]);
+    }
+
     void LayerManager::Update(float dt)
     {
         std::for_each(_layers.begin(), _layers.end(), [dt](auto* lyr) { lyr->Update(dt); });
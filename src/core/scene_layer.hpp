@@ -49,9 +49,11 @@ namespace fin
         void Init() override;
         void Deinit() override;
         void Activate(const Rectf& region) override;
+        virtual void Stream(const Rectf& region);
         void Update(float dt) override;
         void FixedUpdate(float dt) override;
         void Render(Renderer& dc) override;
+        virtual void PreRender(Renderer& dc);
         ObjectLayer* Objects() override;
 
         Vec2f            GetCursorPos() const final;
@@ -87,6 +89,7 @@ namespace fin
 
         void SetSize(Vec2f size);
         void Activate(const Rectf& region);
+        void PreRender(Renderer& dc);
         void Render(Renderer& dc);
         void Update(float dt);
         void FixedUpdate(float dt);
@@ -104,8 +107,9 @@ namespace fin
 
     private:
         Scene&                   _scene;
-        std::vector<SceneLayer*> _layers;
-        int32_t                  _active_layer{0};
+        std::vector<SceneLayer*>               _layers;
+        std::vector<std::unique_ptr<Renderer>> _parts; // command lists recorded by each layer
+        int32_t                                _active_layer{0};
     };
 
 
@@ -5,6 +5,8 @@
 #include "application.hpp"
 #include "renderer.hpp"
 #include "scene.hpp"
+#include "utils/thread_pool.hpp"
+#include <rlgl.h>
 
 namespace fin
 {
@@ -16,25 +18,78 @@ namespace fin
     static int32_t     s_max_visibility{1000};
     static msg::Var    s_copy;
 
-    int32_t ObjectSceneLayer::IsoObject::depth_get()
+    static uint64_t ChunkKey(int32_t x, int32_t y)
     {
-        if (_depth_active)
-            return 0;
+        return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+
+    static Vec2i ChunkFromKey(uint64_t key)
+    {
+        return {int32_t(uint32_t(key >> 32)), int32_t(uint32_t(key))};
+    }
+
+    static uint64_t ChunkKey(Vec2f pos, int32_t size)
+    {
+        return ChunkKey(int32_t(std::floor(pos.x / size)), int32_t(std::floor(pos.y / size)));
+    }
 
-        if (!_depth)
+    static bool IsSpriteVisibleAt(Entity obj, Vec2f position)
+    {
+        auto* spr = Find<CSprite2D>(obj);
+        if (!spr)
+            return true;
+
+        if (!spr->_spr)
+            return false;
+
+        auto rc = spr->GetRegion(Get<CBase>(obj)._position);
+        return spr->_spr->IsAlphaVisible(position.x - rc.x1, position.y - rc.y1);
+    }
+
+    // Changes when any sprite, texture or attachment changes or an entity gains or loses one, the counters only grow
+    static uint64_t SpriteRevision()
+    {
+        return uint64_t(Sprite2D::GetRevision()) + ComponentTraits<CSprite2D>::info->revision +
+               ComponentTraits<CAttachment>::info->revision;
+    }
+
+    // Calls emit(sprite, dest) for every sprite drawn for obj, in draw order
+    template <typename F>
+    static void VisitSprites(Entity obj, F&& emit)
+    {
+        auto* base   = Find<CBase>(obj);
+        auto* sprite = Find<CSprite2D>(obj);
+        if (!base || !sprite)
+            return;
+
+        if (sprite->_spr)
+            emit(*sprite->_spr, sprite->GetRegion(base->_position).rect());
+
+        if (auto* att = Find<CAttachment>(obj))
         {
-            _depth_active = true;
-            if (_back.empty())
-                _depth = 1;
-            else
+            for (auto& el : att->_items)
             {
-                for (auto el : _back)
-                    _depth = std::max(el->depth_get(), _depth);
-                _depth += 1;
+                if (el._sprite)
+                {
+                    Rectf dest;
+                    dest.x      = base->_position.x + el._offset.x - el._sprite->GetOrigin().x;
+                    dest.y      = base->_position.y + el._offset.y - el._sprite->GetOrigin().y;
+                    dest.width  = el._sprite->GetSize().x;
+                    dest.height = el._sprite->GetSize().y;
+                    emit(*el._sprite, dest);
+                }
             }
-            _depth_active = false;
         }
-        return _depth;
+
+        if (s_attachment_target == obj && s_attachment_sprite)
+        {
+            Rectf dest;
+            dest.x      = base->_position.x + s_attachment_offset.x - s_attachment_sprite->GetOrigin().x;
+            dest.y      = base->_position.y + s_attachment_offset.y - s_attachment_sprite->GetOrigin().y;
+            dest.width  = s_attachment_sprite->GetSize().x;
+            dest.height = s_attachment_sprite->GetSize().y;
+            emit(*s_attachment_sprite, dest);
+        }
     }
 
     void ObjectSceneLayer::IsoObject::setup(Entity ent)
@@ -57,7 +112,8 @@ namespace fin
             _origin.point2.y += iso->_y;
         }
 
-        _back.clear();
+        _back_begin = 0;
+        _back_end   = 0;
     }
 
 
@@ -76,21 +132,80 @@ namespace fin
     void ObjectSceneLayer::Serialize(msg::Var& ar)
     {
         SceneLayer::Serialize(ar);
-        msg::Var items;
-        items.make_array(_objects.size());
-
         auto& fact = GetScene()->GetFactory();
 
+        ar.set_item("cw", _cell_size.x);
+        ar.set_item("ch", _cell_size.y);
+        if (_spatial_cell > 0)
+            ar.set_item("sc", _spatial_cell);
+        if (_lod_zoom > 0)
+        {
+            ar.set_item("lz", _lod_zoom);
+            ar.set_item("lc", _lod_cell);
+        }
+
+        if (_chunk_size <= 0)
+        {
+            msg::Var items;
+            items.make_array(_objects.size());
+
+            for (auto ent : _objects)
+            {
+                msg::Var obj;
+                fact.SaveEntity(ent, obj);
+                items.push_back(obj);
+            }
+
+            ar.set_item("items", items);
+            return;
+        }
+
+        // Streamed layers save objects grouped by chunk, resident ones by their current position
+        FinishChunkLoads(true);
+
+        std::map<uint64_t, msg::Var> stored;
+        auto                         chunk_items = [&stored](uint64_t key) -> msg::Var&
+        {
+            auto& items = stored[key];
+            if (items.is_undefined())
+                items.make_array(0);
+            return items;
+        };
+
         for (auto ent : _objects)
         {
+            auto*    base = Find<CBase>(ent);
             msg::Var obj;
             fact.SaveEntity(ent, obj);
-            items.push_back(obj);
+            chunk_items(base ? ChunkKey(base->_position, _chunk_size) : ChunkKey(0, 0)).push_back(obj);
         }
 
-        ar.set_item("items", items);
-        ar.set_item("cw", _cell_size.x);
-        ar.set_item("ch", _cell_size.y);
+        for (auto& [key, chunk] : _chunks)
+        {
+            for (auto& str : chunk->items)
+            {
+                msg::Var obj;
+                obj.from_string(str.c_str());
+                chunk_items(key).push_back(obj);
+            }
+        }
+
+        msg::Var chunks;
+        chunks.make_array(uint32_t(stored.size()));
+        for (auto& [key, items] : stored)
+        {
+            const Vec2i pos = ChunkFromKey(key);
+            msg::Var    chunk;
+            chunk.set_item("x", pos.x);
+            chunk.set_item("y", pos.y);
+            chunk.set_item("items", items);
+            chunks.push_back(chunk);
+        }
+
+        ar.set_item("chunks", chunks);
+        ar.set_item("ck", _chunk_size);
+        ar.set_item("cm", _chunk_margin);
+        ar.set_item("cb", _chunk_budget);
     }
 
     void ObjectSceneLayer::Deserialize(msg::Var& ar)
@@ -100,6 +215,22 @@ namespace fin
         auto& fact  = GetScene()->GetFactory();
         _cell_size.x = ar.get_item("cw").get(16);
         _cell_size.y = ar.get_item("ch").get(8);
+        _dirty_navmesh = true;
+
+        const int32_t spatial_cell = ar.get_item("sc").get(0);
+        if (spatial_cell != _spatial_cell)
+        {
+            _spatial_cell = spatial_cell;
+            Resize(_size);
+        }
+
+        _lod_zoom     = ar.get_item("lz").get(0.f);
+        _lod_cell     = ar.get_item("lc").get(1024);
+        _chunk_size   = ar.get_item("ck").get(0);
+        _chunk_margin = ar.get_item("cm").get(1);
+        _chunk_budget = ar.get_item("cb").get(64);
+        _stream_dirty = true;
+
         auto items = ar.get_item("items");
         for (auto& obj : items.elements())
         {
@@ -108,6 +239,32 @@ namespace fin
             if (ent != entt::null)
                 Insert(ent);
         }
+
+        // Chunked objects stay encoded until the view comes close
+        auto chunks = ar.get_item("chunks");
+        for (auto& chunk : chunks.elements())
+        {
+            const uint64_t key = ChunkKey(chunk.get_item("x").get(0), chunk.get_item("y").get(0));
+            auto           els = chunk.get_item("items");
+            if (_chunk_size > 0)
+            {
+                auto& dst = _chunks[key];
+                if (!dst)
+                    dst = std::make_unique<StreamChunk>();
+                for (auto& obj : els.elements())
+                    obj.to_string(dst->items.emplace_back());
+            }
+            else
+            {
+                for (auto& obj : els.elements())
+                {
+                    Entity ent{entt::null};
+                    fact.LoadEntity(ent, obj);
+                    if (ent != entt::null)
+                        Insert(ent);
+                }
+            }
+        }
         UpdateNavmesh();
     }
 
@@ -122,10 +279,13 @@ namespace fin
                 obj->_layer->Remove(ent);
 
             obj->_layer = this;
+            obj->_bbox  = obj->GetBoundingBox();
             _spatial_db.update_for_new_location(obj);
-            _dirty_navmesh = true;
+            InvalidateLod(obj->_bbox);
         }
         _objects.emplace(ent);
+        InvalidateFootprint(ent);
+        InvalidateIso(ent);
     }
 
     void ObjectSceneLayer::Remove(Entity ent)
@@ -136,9 +296,11 @@ namespace fin
             {
                 auto* lyr = static_cast<ObjectSceneLayer*>(obj->_layer);
                 lyr->_spatial_db.remove_from_bin(obj);
+                lyr->InvalidateLod(obj->_bbox);
                 lyr->_objects.erase(ent);
+                lyr->RemoveFootprint(ent);
+                lyr->InvalidateIso(ent); // not in view any more, dropped on next Activate
             }
-            _dirty_navmesh = true;
         }
         GetScene()->GetFactory().GetRegister().Destroy(ent);
     }
@@ -146,7 +308,7 @@ namespace fin
     Entity ObjectSceneLayer::FindAt(Vec2f position) const
     {
         Entity ret = entt::null;
-        auto   cb  = [&ret, position](lq::SpatialDatabase::Proxy* obj, float dist)
+        auto   cb  = [&ret, position](lq::SpatialDatabase::Proxy* obj)
         {
             auto ent = static_cast<CBase*>(obj)->_self;
             if (auto* spr = Find<CSprite2D>(ent))
@@ -161,47 +323,78 @@ namespace fin
                 }
             }
         };
-        _spatial_db.map_over_all_objects_in_locality(position.x, position.y, TileSize, cb);
-        return entt::null;
+        _spatial_db.map_over_all_objects_at(position, cb);
+        return ret;
     }
 
     Entity ObjectSceneLayer::FindActiveAt(Vec2f position) const
     {
-        for (auto it = _iso.rbegin(); it != _iso.rend(); ++it)
+        for (auto idx : GetPickCandidates(position))
         {
-            auto  obj  = (*it)->_ptr;
-            auto& bbox = (*it)->_bbox;
+            auto  obj  = _iso[idx]->_ptr;
+            auto& bbox = _iso[idx]->_bbox;
 
-            if (bbox.contains(position))
+            if (bbox.contains(position) && IsSpriteVisibleAt(obj, position))
+                return obj;
+        }
+        return entt::null;
+    }
+
+    void ObjectSceneLayer::FindActiveAt(std::span<const Vec2f> points, std::span<Entity> result) const
+    {
+        if (_pick_dirty)
+            UpdatePickGrid();
+
+        for (size_t n = 0; n < points.size() && n < result.size(); ++n)
+            result[n] = FindActiveAt(points[n]);
+    }
+
+    void ObjectSceneLayer::FindActiveIn(const Rectf& area, std::vector<Entity>& result) const
+    {
+        result.clear();
+        if (_pick_dirty)
+            UpdatePickGrid();
+        if (_pick_start.empty())
+            return;
+
+        const Regionf rc(area.x, area.y, area.x2(), area.y2());
+        if (!rc.intersects(_pick_bounds))
+            return;
+
+        auto bin_col = [&](float x) { return std::clamp(int32_t((x - _pick_bounds.x1) * _pick_inv), 0, _pick_cols - 1); };
+        auto bin_row = [&](float y) { return std::clamp(int32_t((y - _pick_bounds.y1) * _pick_inv), 0, _pick_rows - 1); };
+
+        // Objects spanning several bins are found once per bin, collect draw indices and dedupe
+        auto& found = _pick_found;
+        found.clear();
+        for (int32_t r = bin_row(rc.y1), r2 = bin_row(rc.y2); r <= r2; ++r)
+        {
+            for (int32_t c = bin_col(rc.x1), c2 = bin_col(rc.x2); c <= c2; ++c)
             {
-                if (auto* spr = Find<CSprite2D>(obj))
-                {
-                    if (spr->_spr)
-                    {
-                        auto& base = Get<CBase>(obj);
-                        auto  rc   = spr->GetRegion(base._position);
-                        if (spr->_spr->IsAlphaVisible(position.x - rc.x1, position.y - rc.y1))
-                        {
-                            return obj;
-                        }
-                    }
-                }
-                else
+                const int32_t bin = r * _pick_cols + c;
+                for (uint32_t i = _pick_start[bin]; i < _pick_start[bin + 1]; ++i)
                 {
-                    return obj;
+                    if (_iso[_pick_items[i]]->_bbox.intersects(rc))
+                        found.push_back(_pick_items[i]);
                 }
             }
         }
-        return entt::null;
+
+        std::sort(found.begin(), found.end(), std::greater<uint32_t>());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+
+        result.reserve(found.size());
+        for (auto idx : found)
+            result.push_back(_iso[idx]->_ptr);
     }
 
     Entity ObjectSceneLayer::FindActiveAttachmentAt(Vec2f position, int32_t& attachment) const
     {
         attachment = -1;
-        for (auto it = _iso.rbegin(); it != _iso.rend(); ++it)
+        for (auto idx : GetPickCandidates(position))
         {
-            auto  obj  = (*it)->_ptr;
-            auto& bbox = (*it)->_bbox;
+            auto  obj  = _iso[idx]->_ptr;
+            auto& bbox = _iso[idx]->_bbox;
 
             if (bbox.contains(position))
             {
@@ -228,6 +421,83 @@ namespace fin
         return entt::null;
     }
 
+    void ObjectSceneLayer::UpdatePickGrid() const
+    {
+        constexpr float   MinBinSize = 32.f;
+        constexpr int32_t MaxBins    = 128; // per axis
+
+        _pick_dirty = false;
+        _pick_start.clear();
+        _pick_items.clear();
+
+        const uint32_t count = uint32_t(_iso.size());
+        if (!count)
+            return;
+
+        // Uniform grid over the drawn objects, bins about the size of an average object
+        Regionf bounds = _iso[0]->_bbox;
+        float   extent = 0;
+        for (auto* obj : _iso)
+        {
+            const auto& bb = obj->_bbox;
+            bounds.x1      = std::min(bounds.x1, bb.x1);
+            bounds.y1      = std::min(bounds.y1, bb.y1);
+            bounds.x2      = std::max(bounds.x2, bb.x2);
+            bounds.y2      = std::max(bounds.y2, bb.y2);
+            extent += std::max(bb.x2 - bb.x1, bb.y2 - bb.y1);
+        }
+
+        const float bin_size = std::max({extent / count,
+                                         MinBinSize,
+                                         (bounds.x2 - bounds.x1) / MaxBins,
+                                         (bounds.y2 - bounds.y1) / MaxBins});
+        _pick_bounds = bounds;
+        _pick_inv    = 1.f / bin_size;
+        _pick_cols   = std::min(int32_t((bounds.x2 - bounds.x1) * _pick_inv) + 1, MaxBins + 1);
+        _pick_rows   = std::min(int32_t((bounds.y2 - bounds.y1) * _pick_inv) + 1, MaxBins + 1);
+
+        auto bin_col = [&](float x) { return std::clamp(int32_t((x - bounds.x1) * _pick_inv), 0, _pick_cols - 1); };
+        auto bin_row = [&](float y) { return std::clamp(int32_t((y - bounds.y1) * _pick_inv), 0, _pick_rows - 1); };
+
+        // Counting layout, objects are added in reverse draw order so each bin lists the front most first
+        _pick_start.assign(size_t(_pick_cols) * _pick_rows + 1, 0);
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            const auto& bb = _iso[n]->_bbox;
+            for (int32_t r = bin_row(bb.y1), r2 = bin_row(bb.y2); r <= r2; ++r)
+                for (int32_t c = bin_col(bb.x1), c2 = bin_col(bb.x2); c <= c2; ++c)
+                    ++_pick_start[r * _pick_cols + c + 1];
+        }
+        for (size_t n = 1; n < _pick_start.size(); ++n)
+            _pick_start[n] += _pick_start[n - 1];
+
+        _pick_items.resize(_pick_start.back());
+        for (uint32_t n = count; n-- > 0;)
+        {
+            const auto& bb = _iso[n]->_bbox;
+            for (int32_t r = bin_row(bb.y1), r2 = bin_row(bb.y2); r <= r2; ++r)
+                for (int32_t c = bin_col(bb.x1), c2 = bin_col(bb.x2); c <= c2; ++c)
+                    _pick_items[_pick_start[r * _pick_cols + c]++] = n;
+        }
+        for (size_t n = _pick_start.size() - 1; n > 0; --n)
+            _pick_start[n] = _pick_start[n - 1];
+        _pick_start[0] = 0;
+    }
+
+    std::span<const uint32_t> ObjectSceneLayer::GetPickCandidates(Vec2f position) const
+    {
+        if (_pick_dirty)
+            UpdatePickGrid();
+
+        if (_pick_start.empty() || !_pick_bounds.contains(position))
+            return {};
+
+        const int32_t c   = std::min(int32_t((position.x - _pick_bounds.x1) * _pick_inv), _pick_cols - 1);
+        const int32_t r   = std::min(int32_t((position.y - _pick_bounds.y1) * _pick_inv), _pick_rows - 1);
+        const int32_t bin = r * _pick_cols + c;
+        return {_pick_items.data() + _pick_start[bin], _pick_items.data() + _pick_start[bin + 1]};
+    }
+
     std::span<Vec2i> ObjectSceneLayer::FindPath(Vec2i from, Vec2i to) const
     {
         static std::vector<Vec2i> path;
@@ -245,7 +515,6 @@ namespace fin
         auto& obj      = Get<CBase>(ent);
         obj._position = pos;
         Update(&obj);
-        _dirty_navmesh = true;
     }
 
     void ObjectSceneLayer::Move(Entity ent, Vec2f pos)
@@ -253,12 +522,49 @@ namespace fin
         auto& obj = Get<CBase>(ent);
         obj._position += pos;
         Update(&obj);
-        _dirty_navmesh = true;
     }
 
     void ObjectSceneLayer::Update(void* obj)
     {
-        _spatial_db.update_for_new_location(reinterpret_cast<CBase*>(obj));
+        auto* base = reinterpret_cast<CBase*>(obj);
+        if (!_moved.contains(base->_self))
+            _moved.emplace(base->_self);
+    }
+
+    void ObjectSceneLayer::FlushMoved()
+    {
+        if (_moved.empty())
+            return;
+
+        _moved_bases.clear();
+        for (auto ent : _moved)
+        {
+            auto* base = Find<CBase>(ent);
+            if (base && base->_layer == this)
+                _moved_bases.push_back(base);
+        }
+        _moved.clear();
+
+        for (auto* base : _moved_bases)
+            InvalidateLod(base->_bbox);
+
+        // Bounds only read components, so they are computed in parallel
+        ThreadPool::Get().parallel_for(int32_t(_moved_bases.size()),
+                                       256,
+                                       [this](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t n = begin; n < end; ++n)
+                                               _moved_bases[n]->_bbox = _moved_bases[n]->GetBoundingBox();
+                                       });
+
+        // Relinking is cheap and only happens for objects that changed bin
+        for (auto* base : _moved_bases)
+        {
+            _spatial_db.update_for_new_location(base);
+            InvalidateLod(base->_bbox);
+            InvalidateFootprint(base->_self);
+            InvalidateIso(base->_self);
+        }
     }
 
     void ObjectSceneLayer::Update(float dt)
@@ -266,16 +572,105 @@ namespace fin
         if (IsDisabled())
             return;
 
-        GetScene()->GetFactory().OnLayerUpdate(dt, _selected);
+        UpdateNavmesh();
+        UpdateScripts();
+
+        GetScene()->GetFactory().OnLayerUpdate(dt, _scripts);
+    }
+
+    void ObjectSceneLayer::UpdateScripts()
+    {
+        auto& fact = GetScene()->GetFactory();
+
+        // Deltas were dropped, compare the whole active set instead
+        if (_scripts_resync)
+        {
+            _scripts_resync = false;
+            _view_enter.assign(_selected.begin(), _selected.end());
+            _view_leave.assign(_scripted.begin(), _scripted.end());
+        }
+
+        // Deltas may span several frames, so each one is checked against the current state
+        bool leaving = false;
+        for (auto ent : _view_leave)
+        {
+            if (!_selected.contains(ent) && _scripted.contains(ent))
+            {
+                _scripted.erase(ent);
+                leaving = true;
+            }
+        }
+
+        if (leaving)
+        {
+            size_t next = 0;
+            for (auto& script : _scripts)
+            {
+                if (_scripted.contains(script.entity))
+                {
+                    _scripts[next++] = script;
+                    continue;
+                }
+                if (script.info->storage->contains(script.entity))
+                    static_cast<IScriptComponent*>(script.info->storage->get(script.entity))->OnLeaveView();
+            }
+            _scripts.resize(next);
+        }
+
+        // Script components added or removed at runtime, collect again for entities already in view
+        const uint64_t signature = fact.GetScriptSignature();
+        if (signature != _script_signature)
+        {
+            _script_signature = signature;
+            _scripts.clear();
+            for (auto ent : _scripted)
+                fact.CollectScripts(ent, _scripts);
+        }
+
+        for (auto ent : _view_enter)
+        {
+            if (!_selected.contains(ent) || _scripted.contains(ent))
+                continue;
+
+            _scripted.emplace(ent);
+            const size_t first = _scripts.size();
+            fact.CollectScripts(ent, _scripts);
+            for (size_t n = first; n < _scripts.size(); ++n)
+                static_cast<IScriptComponent*>(_scripts[n].info->storage->get(ent))->OnEnterView();
+        }
+
+        _view_enter.clear();
+        _view_leave.clear();
     }
 
     void ObjectSceneLayer::Clear()
     {
+        for (auto* chunk : _chunk_loads)
+            ThreadPool::Get().wait(chunk->jobs);
+        _chunk_loads.clear();
+        _chunks.clear();
+        _stream_dirty = true;
+        _lod_cells.clear();
+        _lod_visible.clear();
+        _lod_active = false;
+        _selected.clear();
+        _scripted.clear();
+        _scripts.clear();
+        _view_enter.clear();
+        _view_leave.clear();
         _iso_pool.clear();
         _iso.clear();
-        _grid_size     = {};
-        _iso_pool_size = {};
+        _iso_index.clear();
+        _iso_moved.clear();
+        _packets.clear();
+        _moved.clear();
+        _iso_dirty = true;
+        _pick_dirty = true;
+        _grid_size = {};
         _objects.clear();
+        _footprints.clear();
+        _dirty_colliders.clear();
+        _dirty_navmesh = true;
     }
 
     void ObjectSceneLayer::Resize(Vec2f size)
@@ -283,9 +678,12 @@ namespace fin
         _size        = size;
         _grid_size.x = (size.width + (TileSize - 1)) / TileSize; // Round up division
         _grid_size.y = (size.height + (TileSize - 1)) / TileSize;
-        _spatial_db.init({0, 0, (float)_grid_size.x * TileSize, (float)_grid_size.y * TileSize},
-                         _grid_size.x,
-                         _grid_size.y);
+        if (_spatial_cell > 0)
+            _spatial_db.init_grid({0, 0, (float)_grid_size.x * TileSize, (float)_grid_size.y * TileSize}, (float)_spatial_cell);
+        else
+            _spatial_db.init({0, 0, (float)_grid_size.x * TileSize, (float)_grid_size.y * TileSize},
+                             _grid_size.x,
+                             _grid_size.y);
 
         for (Entity et : _objects)
         {
@@ -294,157 +692,657 @@ namespace fin
                 obj->_bin   = nullptr;
                 obj->_prev  = nullptr;
                 obj->_next  = nullptr;
+                obj->_cell  = -1;
+                obj->_bbox  = obj->GetBoundingBox();
                 _spatial_db.update_for_new_location(obj);
             }
         }
         _dirty_navmesh = true;
     }
 
-    void ObjectSceneLayer::Activate(const Rectf& region)
+    void ObjectSceneLayer::Stream(const Rectf& region)
     {
-        SceneLayer::Activate(region);
+        FinishChunkLoads(false);
+        if (_chunk_size <= 0)
+            return;
 
-        _selected.clear();
-        _iso_pool_size = 0;
+        const float   size   = float(_chunk_size);
+        const float   margin = float(_chunk_margin) * size;
+        const Regioni range(int32_t(std::floor((region.x - margin) / size)),
+                            int32_t(std::floor((region.y - margin) / size)),
+                            int32_t(std::floor((region.x2() + margin) / size)),
+                            int32_t(std::floor((region.y2() + margin) / size)));
+
+        if (!_stream_dirty && range.x1 == _stream_range.x1 && range.y1 == _stream_range.y1 &&
+            range.x2 == _stream_range.x2 && range.y2 == _stream_range.y2)
+            return;
+
+        _stream_range = range;
+        _stream_dirty = false;
 
-        auto cb = [&](lq::SpatialDatabase::Proxy* item)
+        // Chunks around the view become resident, stored objects are decoded on a worker
+        for (int32_t y = range.y1; y <= range.y2; ++y)
         {
-            if (_iso_pool_size >= _iso_pool.size())
-                _iso_pool.resize(_iso_pool_size + 64);
+            for (int32_t x = range.x1; x <= range.x2; ++x)
+            {
+                auto& chunk = _chunks[ChunkKey(x, y)];
+                if (!chunk)
+                    chunk = std::make_unique<StreamChunk>();
+                if (chunk->resident)
+                    continue;
+
+                chunk->resident = true;
+                if (!chunk->items.empty())
+                    LoadChunk(*chunk);
+            }
+        }
 
-            auto& obj = _iso_pool[_iso_pool_size++];
-            auto ent = static_cast<CBase*>(item)->_self;
+        // Chunks one past the range are kept to avoid thrashing at the border, farther ones are
+        // stored, then the farthest kept ones until the budget holds
+        const Regioni keep(range.x1 - 1, range.y1 - 1, range.x2 + 1, range.y2 + 1);
+        const Vec2i   center((range.x1 + range.x2) / 2, (range.y1 + range.y2) / 2);
+        int32_t       resident = 0;
 
-            obj.setup(ent);
-        };
+        _chunk_evict.clear();
+        for (auto& [key, chunk] : _chunks)
+        {
+            if (!chunk->resident || chunk->loading)
+            {
+                resident += chunk->loading;
+                continue;
+            }
 
+            const Vec2i pos = ChunkFromKey(key);
+            if (!keep.contains(pos))
+            {
+                chunk->resident = false;
+                continue;
+            }
 
-        // Query active region
-        _spatial_db.map_over_all_objects_in_locality({(float)region.x - TileSize,
-                                                      (float)region.y - TileSize,
-                                                      (float)region.width + 2 * TileSize,
-                                                      (float)region.height + 2 * TileSize},
-                                                     cb);
+            ++resident;
+            if (!range.contains(pos))
+                _chunk_evict.emplace_back(std::max(std::abs(pos.x - center.x), std::abs(pos.y - center.y)), chunk.get());
+        }
+
+        if (resident > _chunk_budget)
+        {
+            std::sort(_chunk_evict.begin(), _chunk_evict.end(), [](auto& a, auto& b) { return a.first > b.first; });
+            for (auto& [dist, chunk] : _chunk_evict)
+            {
+                if (resident <= _chunk_budget)
+                    break;
+                chunk->resident = false;
+                --resident;
+            }
+        }
+
+        // Objects standing in chunks that are not resident are encoded and destroyed
+        _stream_objects.assign(_objects.begin(), _objects.end());
+        for (auto ent : _stream_objects)
+        {
+            auto* base = Find<CBase>(ent);
+            if (!base || ent == _edit)
+                continue;
 
-        if (_iso_pool_size >= _iso_pool.size())
-            _iso_pool.resize(_iso_pool_size + 32);
+            auto& chunk = _chunks[ChunkKey(base->_position, _chunk_size)];
+            if (!chunk)
+                chunk = std::make_unique<StreamChunk>();
+            if (!chunk->resident)
+                StoreObject(ent, *chunk);
+        }
+
+        std::erase_if(_chunks,
+                      [](const auto& it)
+                      { return !it.second->resident && !it.second->loading && it.second->items.empty(); });
+    }
+
+    void ObjectSceneLayer::LoadChunk(StreamChunk& chunk)
+    {
+        chunk.loading = true;
+        _chunk_loads.push_back(&chunk);
+        ThreadPool::Get().submit(chunk.jobs,
+                                 [&chunk]()
+                                 {
+                                     chunk.decoded.resize(chunk.items.size());
+                                     for (size_t n = 0; n < chunk.items.size(); ++n)
+                                         chunk.decoded[n].from_string(chunk.items[n].c_str());
+                                 });
+    }
 
-        // Reset iso depth and sort data
-        _iso.resize(_iso_pool_size);
-        for (size_t n = 0; n < _iso_pool_size; ++n)
+    void ObjectSceneLayer::FinishChunkLoads(bool wait)
+    {
+        auto&  fact = GetScene()->GetFactory();
+        size_t next = 0;
+        for (auto* chunk : _chunk_loads)
         {
-            _iso[n] = &_iso_pool[n];
-            _selected.emplace(_iso_pool[n]._ptr);
+            if (wait)
+                ThreadPool::Get().wait(chunk->jobs);
+            else if (chunk->jobs.pending.load(std::memory_order_acquire) > 0)
+            {
+                _chunk_loads[next++] = chunk;
+                continue;
+            }
+
+            // Entities are created here, on the thread that owns the registry
+            for (auto& obj : chunk->decoded)
+            {
+                Entity ent = fact.GetRegister().Create();
+                fact.LoadEntityData(ent, obj);
+                Insert(ent);
+            }
+            chunk->items.clear();
+            chunk->decoded.clear();
+            chunk->loading = false;
         }
+        _chunk_loads.resize(next);
+    }
+
+    void ObjectSceneLayer::LoadChunks()
+    {
+        for (auto& [key, chunk] : _chunks)
+        {
+            if (!chunk->loading && !chunk->items.empty())
+                LoadChunk(*chunk);
+        }
+        FinishChunkLoads(true);
+        _chunks.clear();
+        _stream_dirty = true;
+    }
+
+    void ObjectSceneLayer::StoreObject(Entity ent, StreamChunk& chunk)
+    {
+        msg::Var obj;
+        GetScene()->GetFactory().SaveEntity(ent, obj);
+        obj.to_string(chunk.items.emplace_back());
+        Remove(ent);
+    }
+
+    void ObjectSceneLayer::Activate(const Rectf& region)
+    {
+        constexpr uint32_t MaxRepair = 32; // moved objects re-inserted one by one before falling back to a full sort
+
+        SceneLayer::Activate(region);
+        FlushMoved();
+
+        // Nothing moved, entered or left the view and no sprite changed, keep last frame order and packets
+        const uint64_t revision = SpriteRevision();
+        if (!_iso_dirty && _iso_moved.empty() && _drop == entt::null && _iso_drop == entt::null && region == _iso_region &&
+            revision == _packet_revision)
+            return;
+
+        // Edits that bypass Update may have changed any object, every visible one is read again
+        const bool reread = _iso_dirty;
+
+        _packet_revision = revision;
+        _iso_region = region;
+        _iso_drop   = _drop;
+        _iso_dirty  = false;
+        _pick_dirty = true;
+
+        // Last frame order as pool indices, the pool may grow below
+        _iso_order.resize(_iso.size());
+        for (size_t n = 0; n < _iso.size(); ++n)
+            _iso_order[n] = uint32_t(_iso[n] - _iso_pool.data());
+
+        for (auto& obj : _iso_pool)
+            obj._visible = false;
+
+        uint32_t visible = 0;
+        auto&    setup   = _iso_setup;
+        auto     visit   = [&](Entity ent)
+        {
+            auto [it, inserted] = _iso_index.try_emplace(ent, uint32_t(_iso_pool.size()));
+            if (inserted)
+            {
+                _iso_pool.emplace_back()._ptr = ent;
+                setup.push_back(it->second);
+            }
+            else if (_iso_pool[it->second]._visible)
+            {
+                return;
+            }
+            else if (reread || _iso_moved.contains(ent) || ent == _drop)
+            {
+                setup.push_back(it->second);
+            }
+            _iso_pool[it->second]._visible = true;
+            ++visible;
+        };
+
+        // Query active region
+        _spatial_db.map_over_all_objects_in_region(region,
+                                                   [&](lq::SpatialDatabase::Proxy* item)
+                                                   { visit(static_cast<CBase*>(item)->_self); });
 
         // Add edit object to render queue
         if (_drop != entt::null)
+            visit(_drop);
+
+        _iso_moved.clear();
+
+        // Read new and moved objects, each one only reads its components
+        const uint32_t moved = uint32_t(setup.size());
+        ThreadPool::Get().parallel_for(int32_t(moved),
+                                       128,
+                                       [&](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t n = begin; n < end; ++n)
+                                           {
+                                               auto& obj = _iso_pool[setup[n]];
+                                               obj.setup(obj._ptr);
+                                               obj._moved = true;
+                                           }
+                                       });
+        setup.clear();
+
+        // Forget objects that left the view, compact the pool and remap last frame order
+        const bool membership = moved || visible != _iso_pool.size();
+        if (visible != _iso_pool.size())
         {
-            _iso_pool[_iso_pool_size].setup(_drop);
-            _iso.emplace_back();
-            _iso[_iso_pool_size] = &_iso_pool[_iso_pool_size];
-            _selected.emplace(_iso_pool[_iso_pool_size]._ptr);
+            auto& remap = _iso_remap;
+            remap.resize(_iso_pool.size());
+
+            uint32_t next = 0;
+            for (uint32_t n = 0; n < _iso_pool.size(); ++n)
+            {
+                if (!_iso_pool[n]._visible)
+                {
+                    _iso_index.erase(_iso_pool[n]._ptr);
+                    remap[n] = UINT32_MAX;
+                    continue;
+                }
+                if (next != n)
+                {
+                    _iso_pool[next]                   = _iso_pool[n];
+                    _iso_index[_iso_pool[next]._ptr] = next;
+                }
+                remap[n] = next++;
+            }
+            _iso_pool.resize(next);
+
+            size_t count = 0;
+            for (auto idx : _iso_order)
+            {
+                if (remap[idx] != UINT32_MAX)
+                    _iso_order[count++] = remap[idx];
+            }
+            _iso_order.resize(count);
+        }
+
+        // Repair the order, moved and new objects are re-inserted between what is behind and in front of them
+        bool repaired = moved <= MaxRepair && moved * 4 <= _iso_pool.size();
+        if (moved && repaired)
+        {
+            std::erase_if(_iso_order, [&](uint32_t idx) { return _iso_pool[idx]._moved; });
+            for (uint32_t n = 0; n < _iso_pool.size() && repaired; ++n)
+            {
+                if (_iso_pool[n]._moved)
+                    repaired = InsertIso(n);
+            }
         }
 
+        if (repaired)
+        {
+            _iso.resize(_iso_order.size());
+            for (size_t n = 0; n < _iso_order.size(); ++n)
+                _iso[n] = &_iso_pool[_iso_order[n]];
+        }
+        else
+        {
+            _iso.resize(_iso_pool.size());
+            _iso_sort.sort(_iso_pool, _iso);
+        }
 
-        // Topology sort
-        if (_iso.size() > 1)
+        for (auto& obj : _iso_pool)
+            obj._moved = false;
+
+        ResolvePackets();
+
+        if (membership)
         {
-            // Determine depth relationships
-            for (size_t i = 0; i < _iso.size(); ++i)
+            // Enter and leave deltas against the previous active set, consumed by UpdateScripts
+            const size_t entered = _view_enter.size();
+            for (auto& obj : _iso_pool)
+            {
+                if (!_selected.contains(obj._ptr))
+                    _view_enter.push_back(obj._ptr);
+            }
+
+            const size_t left = _view_leave.size();
+            if (_selected.size() + (_view_enter.size() - entered) != _iso_pool.size())
             {
-                auto* a = _iso[i];
-                for (size_t j = i + 1; j < _iso.size(); ++j)
+                for (auto ent : _selected)
                 {
-                    auto* b = _iso[j];
-                    // Ignore non overlaped rectangles
-                    if (a->_bbox.intersects(b->_bbox))
+                    if (!_iso_index.contains(ent))
+                        _view_leave.push_back(ent);
+                }
+            }
+
+            for (size_t n = left; n < _view_leave.size(); ++n)
+                _selected.erase(_view_leave[n]);
+            for (size_t n = entered; n < _view_enter.size(); ++n)
+                _selected.emplace(_view_enter[n]);
+
+            // Nobody consumed the deltas for a while (editor, disabled layer), drop them
+            if (_view_enter.size() + _view_leave.size() > 4 * _iso_pool.size() + 1024)
+            {
+                _view_enter.clear();
+                _view_leave.clear();
+                _scripts_resync = true;
+            }
+        }
+    }
+
+    bool ObjectSceneLayer::InsertIso(uint32_t index)
+    {
+        const auto& obj    = _iso_pool[index];
+        size_t      behind = 0;
+        size_t      front  = _iso_order.size();
+
+        // Same orientation rule as IsoSort, the pair is judged from the lower pool index
+        for (size_t n = 0; n < _iso_order.size(); ++n)
+        {
+            const uint32_t other = _iso_order[n];
+            const auto&    ot    = _iso_pool[other];
+            if (!obj._bbox.intersects(ot._bbox))
+                continue;
+
+            const uint32_t lo        = std::min(index, other);
+            const uint32_t hi        = std::max(index, other);
+            const bool     lo_before = _iso_pool[hi]._origin.compare(_iso_pool[lo]._origin) < 0;
+            if (lo_before == (lo == other))
+                behind = n + 1;
+            else if (front == _iso_order.size())
+                front = n;
+        }
+
+        if (behind > front)
+            return false; // needs other objects to move as well
+
+        _iso_order.insert(_iso_order.begin() + behind, index);
+        return true;
+    }
+
+    void ObjectSceneLayer::RenderObject(Renderer& dc, Entity ent) const
+    {
+        VisitSprites(ent,
+                     [&dc](const Sprite2D& spr, const Rectf& dest)
+                     { dc.render_texture(spr.GetTexture()->get_texture(), spr.GetRect(), dest); });
+    }
+
+    void ObjectSceneLayer::ResolvePackets()
+    {
+        constexpr int32_t Grain = 256;
+
+        // Count first so every job fills its own range of the flat array
+        const int32_t count = int32_t(_iso.size());
+        ThreadPool::Get().parallel_for(count,
+                                       Grain,
+                                       [this](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t n = begin; n < end; ++n)
+                                           {
+                                               uint32_t size = 0;
+                                               VisitSprites(_iso[n]->_ptr, [&size](const Sprite2D&, const Rectf&) { ++size; });
+                                               _iso[n]->_packet_end = size;
+                                           }
+                                       });
+
+        uint32_t total = 0;
+        for (auto* obj : _iso)
+        {
+            obj->_packet_begin = total;
+            total += obj->_packet_end;
+            obj->_packet_end = total;
+        }
+        _packets.resize(total);
+
+        ThreadPool::Get().parallel_for(count,
+                                       Grain,
+                                       [this](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t n = begin; n < end; ++n)
+                                           {
+                                               auto* out = _packets.data() + _iso[n]->_packet_begin;
+                                               VisitSprites(_iso[n]->_ptr,
+                                                            [&out](const Sprite2D& spr, const Rectf& dest)
+                                                            {
+                                                                const auto* txt   = spr.GetTexture()->get_texture();
+                                                                const auto  src   = spr.GetRect();
+                                                                const float inv_w = 1.f / txt->width;
+                                                                const float inv_h = 1.f / txt->height;
+                                                                *out++ = {txt->id,
+                                                                          {src.x * inv_w, src.y * inv_h, src.x2() * inv_w, src.y2() * inv_h},
+                                                                          dest,
+                                                                          WHITE};
+                                                            });
+                                           }
+                                       });
+    }
+
+    void ObjectSceneLayer::PreRender(Renderer& dc)
+    {
+        constexpr int32_t MaxLodBakes = 4;   // impostors baked per frame, other cells draw their objects
+        constexpr size_t  MaxLodCells = 256; // cached impostors before hidden ones are released
+
+        _lod_visible.clear();
+        _lod_ready  = true;
+        _lod_active = !IsHidden() && _lod_zoom > 0 && _lod_cell > 0 && dc._camera.zoom < _lod_zoom &&
+                      s_max_visibility >= 1000;
+        if (!_lod_active)
+            return;
+
+        const float   size = float(_lod_cell);
+        const Regioni range(int32_t(std::floor(_region.x / size)),
+                            int32_t(std::floor(_region.y / size)),
+                            int32_t(std::floor(_region.x2() / size)),
+                            int32_t(std::floor(_region.y2() / size)));
+
+        if (_lod_cells.size() > MaxLodCells)
+        {
+            std::erase_if(_lod_cells, [&](const auto& it) { return !range.contains(ChunkFromKey(it.first)); });
+        }
+
+        int32_t bakes = 0;
+        for (int32_t y = range.y1; y <= range.y2; ++y)
+        {
+            for (int32_t x = range.x1; x <= range.x2; ++x)
+            {
+                auto& cell = _lod_cells[ChunkKey(x, y)];
+                if (!cell)
+                {
+                    cell        = std::make_unique<LodCell>();
+                    cell->_area = {x * size, y * size, size, size};
+                }
+
+                if (cell->_dirty)
+                {
+                    if (bakes == MaxLodBakes)
                     {
-                        // Check if x2 is above iso line
-                        if (b->_origin.compare(a->_origin) >= 0)
-                        {
-                            a->_back.push_back(b);
-                        }
-                        else
-                        {
-                            b->_back.push_back(a);
-                        }
+                        _lod_ready = false;
+                        continue;
                     }
+                    BakeLodCell(dc, *cell);
+                    ++bakes;
                 }
+                _lod_visible.push_back(cell.get());
             }
+        }
+    }
+
+    void ObjectSceneLayer::BakeLodCell(Renderer& dc, LodCell& cell)
+    {
+        const int32_t res = std::max(int32_t(std::ceil(cell._area.width * _lod_zoom)), 1);
+        if (!cell._texture || cell._texture.get_width() != res)
+        {
+            cell._texture.create(res, res);
+            SetTextureFilter(cell._texture.get_texture()->texture, TEXTURE_FILTER_BILINEAR);
+        }
+
+        // Objects outside the view have no iso order, at this scale sorting by position is close enough
+        _lod_objects.clear();
+        _spatial_db.map_over_all_objects_in_region(cell._area,
+                                                   [&](lq::SpatialDatabase::Proxy* item)
+                                                   { _lod_objects.push_back(static_cast<CBase*>(item)); });
+        std::sort(_lod_objects.begin(),
+                  _lod_objects.end(),
+                  [](const CBase* a, const CBase* b)
+                  {
+                      return a->_position.y < b->_position.y ||
+                             (a->_position.y == b->_position.y && a->_position.x < b->_position.x);
+                  });
+
+        BeginTextureMode(*cell._texture.get_texture());
+        ClearBackground(BLANK);
+        rlSetBlendFactorsSeparate(0x0302, 0x0303, 1, 0x0303, 0x8006, 0x8006);
+        BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+        Camera2D camera{{0, 0}, {cell._area.x, cell._area.y}, 0, float(res) / cell._area.width};
+        BeginMode2D(camera);
+        dc.set_color(WHITE);
+        for (auto* base : _lod_objects)
+            RenderObject(dc, base->_self);
+        dc.flush();
+        EndMode2D();
 
-            // Recursive function to calculate depth
-            for (auto* obj : _iso)
-                obj->depth_get();
+        EndBlendMode();
+        EndTextureMode();
 
-            // Sort objects by depth
-            std::sort(_iso.begin(),
-                      _iso.end(),
-                      [](const IsoObject* a, const IsoObject* b) { return a->_depth < b->_depth; });
+        cell._dirty = false;
+    }
+
+    void ObjectSceneLayer::InvalidateLod(const Regionf& bbox)
+    {
+        if (_lod_cells.empty() || _lod_cell <= 0)
+            return;
+
+        const float size = float(_lod_cell);
+        for (int32_t y = int32_t(std::floor(bbox.y1 / size)), y2 = int32_t(std::floor(bbox.y2 / size)); y <= y2; ++y)
+        {
+            for (int32_t x = int32_t(std::floor(bbox.x1 / size)), x2 = int32_t(std::floor(bbox.x2 / size)); x <= x2; ++x)
+            {
+                auto it = _lod_cells.find(ChunkKey(x, y));
+                if (it != _lod_cells.end())
+                    it->second->_dirty = true;
+            }
         }
     }
 
+    bool ObjectSceneLayer::IsLodBaked(const Regionf& bbox) const
+    {
+        const float size = float(_lod_cell);
+        for (int32_t y = int32_t(std::floor(bbox.y1 / size)), y2 = int32_t(std::floor(bbox.y2 / size)); y <= y2; ++y)
+        {
+            for (int32_t x = int32_t(std::floor(bbox.x1 / size)), x2 = int32_t(std::floor(bbox.x2 / size)); x <= x2; ++x)
+            {
+                auto it = _lod_cells.find(ChunkKey(x, y));
+                if (it == _lod_cells.end() || it->second->_dirty)
+                    return false;
+            }
+        }
+        return true;
+    }
+
     void ObjectSceneLayer::Render(Renderer& dc)
     {
+        constexpr float MinLodPixels = 2.f; // objects smaller than this on screen are skipped while their cell waits for a bake
+        constexpr int32_t RenderGrain = 1024; // iso entries recorded per job
+
         if (IsHidden())
             return;
 
         dc.set_color(WHITE);
 
-        auto& reg = GetScene()->GetFactory().GetRegister();
-        auto sprites = View<CSprite2D, CBase>();
+        // Zoomed out, cells draw as one impostor quad each, objects only where a cell is not baked yet
+        if (_lod_active)
+        {
+            for (auto* cell : _lod_visible)
+            {
+                const auto* txt = &cell->_texture.get_texture()->texture;
+                dc.render_texture(txt, {0, float(txt->height), float(txt->width), -float(txt->height)}, cell->_area);
+            }
 
-        for (auto ent : _iso)
+            if (_lod_ready && _iso_drop == entt::null && s_attachment_target == entt::null)
+                return;
+        }
+
+        // Objects moved or inserted since Activate and the ones being edited are read again,
+        // every object is when a sprite changed after the packets were resolved
+        const bool changed = !_moved.empty() || !_iso_moved.empty();
+        const bool stale   = SpriteRevision() != _packet_revision;
+
+        auto render = [&](Renderer& part, int32_t begin, int32_t end)
         {
-            if (s_max_visibility < 1000)
+            auto& commands = part.get_commands();
+            for (int32_t n = begin; n < end; ++n)
             {
-                if (auto* iso = Find<CIsometric>(ent->_ptr))
+                auto* ent = _iso[n];
+                if (s_max_visibility < 1000)
                 {
-                    if (s_max_visibility < iso->_y)
-                        continue;
+                    if (auto* iso = Find<CIsometric>(ent->_ptr))
+                    {
+                        if (s_max_visibility < iso->_y)
+                            continue;
+                    }
                 }
-            }
 
-            if (sprites.Contains(ent->_ptr))
-            {
-                auto& base   = Get<CBase>(ent->_ptr);
-                auto& sprite = Get<CSprite2D>(ent->_ptr);
+                if (_lod_active && ent->_ptr != _iso_drop && ent->_ptr != s_attachment_target)
+                {
+                    const auto& bb = ent->_bbox;
+                    if (std::max(bb.width(), bb.height()) * dc._camera.zoom < MinLodPixels || IsLodBaked(bb))
+                        continue;
+                }
 
-                if (sprite._spr)
+                if (ent->_ptr == _iso_drop || ent->_ptr == s_attachment_target ||
+                    (changed && (_moved.contains(ent->_ptr) || _iso_moved.contains(ent->_ptr))))
                 {
-                    dc.render_texture(sprite._spr->GetTexture()->get_texture(),
-                                      sprite._spr->GetRect(),
-                                      sprite.GetRegion(base._position).rect());
+                    RenderObject(part, ent->_ptr);
+                    continue;
                 }
 
-                if (Contains<CAttachment>(ent->_ptr))
+                // Removed since Activate
+                if (!_objects.contains(ent->_ptr))
+                    continue;
+
+                if (stale)
                 {
-                    auto& att = Get<CAttachment>(ent->_ptr);
-                    for (auto& el : att._items)
-                    {
-                        if (el._sprite)
-                        {
-                            Rectf dest;
-                            dest.x      = base._position.x + el._offset.x - el._sprite->GetOrigin().x;
-                            dest.y      = base._position.y + el._offset.y - el._sprite->GetOrigin().y;
-                            dest.width  = el._sprite->GetSize().x;
-                            dest.height = el._sprite->GetSize().y;
-                            dc.render_texture(el._sprite->GetTexture()->get_texture(), el._sprite->GetRect(), dest);
-                        }
-                    }
+                    RenderObject(part, ent->_ptr);
+                    continue;
                 }
 
-                if (s_attachment_target == ent->_ptr && s_attachment_sprite)
+                for (uint32_t p = ent->_packet_begin; p < ent->_packet_end; ++p)
                 {
-                    Rectf dest;
-                    dest.x      = base._position.x + s_attachment_offset.x - s_attachment_sprite->GetOrigin().x;
-                    dest.y      = base._position.y + s_attachment_offset.y - s_attachment_sprite->GetOrigin().y;
-                    dest.width  = s_attachment_sprite->GetSize().x;
-                    dest.height = s_attachment_sprite->GetSize().y;
-                    dc.render_texture(s_attachment_sprite->GetTexture()->get_texture(), s_attachment_sprite->GetRect(), dest);
+                    const auto& pk = _packets[p];
+                    commands.add_quad(pk.texture, pk.dest, pk.uv, pk.color);
                 }
             }
+        };
+
+        // Runs of the iso order record on the pool and join in order, so the draw order is unchanged
+        const int32_t count = int32_t(_iso.size());
+        const int32_t parts = (count + RenderGrain - 1) / RenderGrain;
+        if (parts <= 1)
+        {
+            render(dc, 0, count);
+            return;
         }
+
+        while (_render_parts.size() < size_t(parts))
+            _render_parts.push_back(std::make_unique<Renderer>());
+
+        ThreadPool::Get().parallel_for(parts,
+                                       1,
+                                       [&](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t p = begin; p < end; ++p)
+                                           {
+                                               _render_parts[p]->inherit(dc);
+                                               render(*_render_parts[p], p * RenderGrain, std::min(count, (p + 1) * RenderGrain));
+                                           }
+                                       });
+
+        for (int32_t p = 0; p < parts; ++p)
+            dc.append(*_render_parts[p]);
     }
 
     bool ObjectSceneLayer::ImguiWorkspace(ImGui::CanvasParams& canvas)
@@ -587,6 +1485,7 @@ namespace fin
                         if (!Contains<CAttachment>(s_attachment_target))
                             Emplace<CAttachment>(s_attachment_target);
                         Get<CAttachment>(s_attachment_target).Append(payload_n->shared_from_this(), s_attachment_offset);
+                        Update(&base); // bounds grew, re-read on next Activate
                         s_attachment_sprite = {};
                         s_attachment_target = entt::null;
                     }
@@ -689,6 +1588,14 @@ namespace fin
             }
         }
 
+        // Attachment and drag edits change bounds without going through Update
+        if (modified)
+        {
+            _iso_dirty = true;
+            if (auto* base = Find<CBase>(_edit); base && base->_layer == this)
+                Update(base);
+        }
+
         return modified;
     }
 
@@ -729,6 +1636,53 @@ namespace fin
         {
             _dirty_navmesh = true;
         }
+
+        // 0 keeps the linked list bins of TileSize, otherwise objects are kept in a grid of this cell size
+        if (ImGui::InputInt("Spatial cell", &_spatial_cell))
+        {
+            _spatial_cell = std::max(_spatial_cell, 0);
+            Resize(_size);
+        }
+
+        // Below this camera zoom objects are drawn from impostor textures baked per cell, 0 disables
+        if (ImGui::InputFloat("LOD zoom", &_lod_zoom) | ImGui::InputInt("LOD cell", &_lod_cell))
+        {
+            _lod_zoom = std::max(_lod_zoom, 0.f);
+            _lod_cell = std::max(_lod_cell, 64);
+            _lod_cells.clear();
+            _lod_visible.clear();
+            _lod_active = false;
+        }
+
+        // 0 keeps every object resident, otherwise objects are streamed in chunks of this size around the view
+        int32_t chunk_size = _chunk_size;
+        if (ImGui::InputInt("Stream chunk", &chunk_size) && std::max(chunk_size, 0) != _chunk_size)
+        {
+            LoadChunks();
+            _chunk_size = std::max(chunk_size, 0);
+        }
+
+        if (_chunk_size > 0)
+        {
+            if (ImGui::InputInt("Stream margin", &_chunk_margin))
+            {
+                _chunk_margin = std::max(_chunk_margin, 0);
+                _stream_dirty = true;
+            }
+            if (ImGui::InputInt("Chunk budget", &_chunk_budget))
+            {
+                _chunk_budget = std::max(_chunk_budget, 1);
+                _stream_dirty = true;
+            }
+
+            size_t stored = 0;
+            for (auto& [key, chunk] : _chunks)
+                stored += chunk->items.size();
+            ImGui::Text("Chunks: %d, stored objects: %d", int32_t(_chunks.size()), int32_t(stored));
+        }
+
+        const auto stats = _navmesh.pathCacheStats();
+        ImGui::Text("Path cache: %llu hits, %llu misses", (unsigned long long)stats.hits, (unsigned long long)stats.misses);
     }
 
     bool ObjectSceneLayer::ImguiUpdate(bool items)
@@ -810,7 +1764,15 @@ namespace fin
         }
         else if (_edit != entt::null)
         {
-            modified |= GetScene()->GetFactory().ImguiPrefab(GetScene(), _edit);
+            if (GetScene()->GetFactory().ImguiPrefab(GetScene(), _edit))
+            {
+                InvalidateFootprint(_edit);
+                InvalidateIso(_edit);
+                // Sprite or collider edits change the proxy box used for culling and picking
+                if (auto* base = Find<CBase>(_edit); base && base->_layer == this)
+                    Update(base);
+                modified = true;
+            }
         }
 
         if (items)
@@ -864,6 +1826,11 @@ namespace fin
         return _navmesh;
     }
 
+    const lq::SpatialDatabase& ObjectSceneLayer::GetSpatialDatabase() const
+    {
+        return _spatial_db;
+    }
+
     const SparseSet& ObjectSceneLayer::GetObjects(bool active_only) const
     {
         return active_only ? _selected : _objects;
@@ -876,27 +1843,91 @@ namespace fin
 
     void ObjectSceneLayer::UpdateNavmesh()
     {
-        if (!_dirty_navmesh)
-            return;
-
-        _dirty_navmesh = false;
-        _navmesh.resize(_size.x, _size.y, _cell_size.x, _cell_size.y);
-        _navmesh.resetTerrain();
-        std::vector<Vec2f> points;
-        for (Entity et : _objects)
+        if (_dirty_navmesh)
         {
-            if (Contains<CBase>(et) && Contains<CCollider>(et))
+            // Full rebuild, grid layout changed
+            _dirty_navmesh = false;
+            _navmesh.resize(_size.x, _size.y, _cell_size.x, _cell_size.y);
+            _navmesh.resetTerrain();
+            _footprints.clear();
+            _dirty_colliders.clear();
+
+            std::vector<Vec2f> points;
+            for (Entity et : _objects)
             {
-                auto& obj = Get<CBase>(et);
-                auto& col = Get<CCollider>(et);
-                points.clear();
-                std::for_each(col._points.begin(),
-                              col._points.end(),
-                              [&points, obj](const Vec2f& pt) { points.push_back(pt + obj._position); });
-
-                _navmesh.applyTerrain(points, TERRAIN_BLOCKED, true);
+                if (MakeFootprint(et, points))
+                    _footprints.emplace(et, std::move(points));
             }
+
+            std::vector<const std::vector<Vec2f>*> polys;
+            polys.reserve(_footprints.size());
+            for (auto& [ent, points] : _footprints)
+                polys.push_back(&points);
+
+            // Batched rasterization, rows are filled in parallel
+            _navmesh.applyObstacles(polys, true);
+            return;
         }
+
+        // Re-rasterize only colliders that moved or changed
+        for (Entity et : _dirty_colliders)
+            UpdateFootprint(et);
+        _dirty_colliders.clear();
+    }
+
+    bool ObjectSceneLayer::MakeFootprint(Entity ent, std::vector<Vec2f>& points) const
+    {
+        points.clear();
+        if (!_objects.contains(ent) || !Contains<CBase>(ent) || !Contains<CCollider>(ent))
+            return false;
+
+        auto& obj = Get<CBase>(ent);
+        auto& col = Get<CCollider>(ent);
+        if (col._points.size() < 3)
+            return false;
+
+        points.reserve(col._points.size());
+        for (const auto& pt : col._points)
+            points.push_back(pt + obj._position);
+        return true;
+    }
+
+    void ObjectSceneLayer::UpdateFootprint(Entity ent)
+    {
+        RemoveFootprint(ent);
+
+        std::vector<Vec2f> points;
+        if (!MakeFootprint(ent, points))
+            return;
+
+        _navmesh.applyObstacle(points, true);
+        _footprints.emplace(ent, std::move(points));
+    }
+
+    void ObjectSceneLayer::RemoveFootprint(Entity ent)
+    {
+        auto it = _footprints.find(ent);
+        if (it == _footprints.end())
+            return;
+
+        _navmesh.applyObstacle(it->second, false);
+        _footprints.erase(it);
+    }
+
+    void ObjectSceneLayer::InvalidateIso(Entity ent)
+    {
+        if (!_iso_moved.contains(ent))
+            _iso_moved.emplace(ent);
+    }
+
+    void ObjectSceneLayer::InvalidateFootprint(Entity ent)
+    {
+        if (_dirty_navmesh || _dirty_colliders.contains(ent))
+            return;
+
+        // Objects without collider never touch the navmesh
+        if (_footprints.contains(ent) || Contains<CCollider>(ent))
+            _dirty_colliders.emplace(ent);
     }
 
 
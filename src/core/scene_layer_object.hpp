@@ -3,7 +3,10 @@
 #include "include.hpp"
 #include "scene_layer.hpp"
 #include "utils/lquery.hpp"
+#include "utils/iso_sort.hpp"
 #include "navmesh.hpp"
+#include "ecs/factory.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace ImGui
 {
@@ -12,19 +15,50 @@ namespace ImGui
 
 namespace fin
 {
+    struct CBase;
+
     class ObjectSceneLayer : public ObjectLayer, public SceneLayer
     {
         struct IsoObject
         {
-            int32_t                 _depth        : 31;
-            bool                    _depth_active : 1;
-            Line<float>             _origin;
-            Region<float>           _bbox;
-            Entity                  _ptr;
-            std::vector<IsoObject*> _back;
-
-            int32_t                 depth_get();
-            void                    setup(Entity ent);
+            int32_t       _depth        : 31;
+            bool          _depth_active : 1;
+            Line<float>   _origin;
+            Region<float> _bbox;
+            Entity        _ptr;
+            uint32_t      _back_begin; // objects behind this one, range in the edges of _iso_sort
+            uint32_t      _back_end;
+            bool          _visible;    // seen by this frame query
+            bool          _moved;      // needs to be placed again in the order
+            uint32_t      _packet_begin; // resolved sprites, range in _packets
+            uint32_t      _packet_end;
+
+            void          setup(Entity ent);
+        };
+
+        /// Sprite quad resolved in Activate, Render replays these without reading components.
+        struct RenderPacket
+        {
+            uint32_t texture;
+            Regionf  uv; // normalized
+            Regionf  dest;
+            Color    color;
+        };
+
+        struct LodCell
+        {
+            RenderTexture2D _texture;
+            Rectf           _area;
+            bool            _dirty{true};
+        };
+
+        struct StreamChunk
+        {
+            std::vector<std::string> items;   // stored objects, one encoded entity each
+            std::vector<msg::Var>    decoded; // filled by the loader job
+            ThreadPool::Group        jobs;
+            bool                     resident{};
+            bool                     loading{};
         };
 
     public:
@@ -39,16 +73,21 @@ namespace fin
         Entity           FindAt(Vec2f position) const final;
         Entity           FindActiveAt(Vec2f position) const final;
         Entity           FindActiveAttachmentAt(Vec2f position, int32_t& attachment) const;
+        void             FindActiveAt(std::span<const Vec2f> points, std::span<Entity> result) const;
+        void             FindActiveIn(const Rectf& area, std::vector<Entity>& result) const;
         std::span<Vec2i> FindPath(Vec2i from, Vec2i to) const final;
         bool             FindPath(Vec2i from, Vec2i to, std::vector<Vec2i>& path) const;
         Navmesh&         GetNavmesh();
         const Navmesh&   GetNavmesh() const;
+        const lq::SpatialDatabase& GetSpatialDatabase() const;
         const SparseSet& GetObjects(bool active_only = false) const final;
         ObjectLayer*     Objects() final;
 
         void             Update(float dt) final;
         void             Render(Renderer& dc) final;
+        void             PreRender(Renderer& dc) final;
         void             Activate(const Rectf& region) final;
+        void             Stream(const Rectf& region) final;
         void             Serialize(msg::Var& ar) final;
         void             Deserialize(msg::Var& ar) final;
         void             Clear() final;
@@ -61,22 +100,87 @@ namespace fin
 
     protected:
         void UpdateNavmesh();
+        void FlushMoved();
+        bool MakeFootprint(Entity ent, std::vector<Vec2f>& points) const;
+        void UpdateFootprint(Entity ent);
+        void RemoveFootprint(Entity ent);
+        void InvalidateFootprint(Entity ent);
         void SelectEdit(Entity ent);
+        void InvalidateIso(Entity ent);
+        bool InsertIso(uint32_t index);
+        void UpdatePickGrid() const;
+        std::span<const uint32_t> GetPickCandidates(Vec2f position) const;
+        void LoadChunk(StreamChunk& chunk);
+        void LoadChunks();
+        void FinishChunkLoads(bool wait);
+        void StoreObject(Entity ent, StreamChunk& chunk);
+        void UpdateScripts();
+        void RenderObject(Renderer& dc, Entity ent) const;
+        void ResolvePackets();
+        void BakeLodCell(Renderer& dc, LodCell& cell);
+        void InvalidateLod(const Regionf& bbox);
+        bool IsLodBaked(const Regionf& bbox) const;
 
-        SparseSet               _objects;
-        SparseSet               _selected;
-        Vec2i                   _grid_size{0, 0};
-        Vec2i                   _cell_size{16, 8};
-        Vec2f                   _size;
-        lq::SpatialDatabase     _spatial_db;
-        std::vector<IsoObject>  _iso_pool;
-        std::vector<IsoObject*> _iso;
-        Navmesh                 _navmesh;
-        uint32_t                _iso_pool_size{};
-        int32_t                 _inflate{};
-        Entity                  _edit{entt::null};
-        Entity                  _drop{entt::null};
-        bool                    _dirty_navmesh{};
+        SparseSet                                      _objects;
+        SparseSet                                      _selected;
+        SparseSet                                      _scripted;   // entities with entries in _scripts
+        std::vector<ActiveScript>                      _scripts;    // script components of active entities
+        std::vector<Entity>                            _view_enter; // deltas of _selected since last Update
+        std::vector<Entity>                            _view_leave;
+        uint64_t                                       _script_signature{};
+        bool                                           _scripts_resync{};
+        SparseSet                                      _dirty_colliders;
+        SparseSet                                      _iso_moved; // objects to re-read on next Activate
+        SparseSet                                      _moved;     // objects to re-bin on next Activate
+        std::vector<CBase*>                            _moved_bases;
+        Vec2i                                          _grid_size{0, 0};
+        Vec2i                                          _cell_size{16, 8};
+        Vec2f                                          _size;
+        lq::SpatialDatabase                            _spatial_db;
+        std::vector<IsoObject>                         _iso_pool;
+        std::vector<IsoObject*>                        _iso;
+        std::unordered_map<Entity, uint32_t>           _iso_index;     // visible entity to pool index
+        std::vector<uint32_t>                          _iso_order;     // scratch, draw order as pool indices
+        std::vector<uint32_t>                          _iso_setup;     // scratch, pool indices to read again
+        std::vector<uint32_t>                          _iso_remap;     // scratch, pool index before and after compaction
+        IsoSort<IsoObject>                             _iso_sort;
+        std::vector<RenderPacket>                      _packets;       // sprites of _iso in draw order
+        uint64_t                                       _packet_revision{}; // SpriteRevision the packets were resolved at
+        mutable std::vector<uint32_t>                  _pick_start; // pick grid bin ranges in _pick_items
+        mutable std::vector<uint32_t>                  _pick_items; // indices into _iso, front to back per bin
+        mutable std::vector<uint32_t>                  _pick_found; // scratch, area pick results
+        mutable Regionf                                _pick_bounds;
+        mutable float                                  _pick_inv{};
+        mutable int32_t                                _pick_cols{};
+        mutable int32_t                                _pick_rows{};
+        mutable bool                                   _pick_dirty{true};
+        std::unordered_map<Entity, std::vector<Vec2f>> _footprints; // collider polygons applied to navmesh
+        Navmesh                                        _navmesh;
+        std::unordered_map<uint64_t, std::unique_ptr<StreamChunk>> _chunks;
+        std::vector<StreamChunk*>                      _chunk_loads; // decoding on workers
+        std::vector<std::pair<int32_t, StreamChunk*>>  _chunk_evict; // scratch, (distance, chunk)
+        std::vector<Entity>                            _stream_objects; // scratch
+        Regioni                                        _stream_range;
+        std::unordered_map<uint64_t, std::unique_ptr<LodCell>> _lod_cells;
+        std::vector<LodCell*>                          _lod_visible; // baked cells in view this frame
+        std::vector<CBase*>                            _lod_objects; // scratch, objects of the cell being baked
+        std::vector<std::unique_ptr<Renderer>>         _render_parts; // command lists of iso runs recorded in parallel
+        float                                          _lod_zoom{};      // 0 always draws objects
+        int32_t                                        _lod_cell{1024};  // world size of an impostor cell
+        bool                                           _lod_active{};
+        bool                                           _lod_ready{};     // every visible cell is baked
+        int32_t                                        _chunk_size{};    // 0 keeps every object resident
+        int32_t                                        _chunk_margin{1}; // chunks loaded around the view
+        int32_t                                        _chunk_budget{64}; // resident chunks
+        bool                                           _stream_dirty{true};
+        Rectf                                          _iso_region;
+        Entity                                         _iso_drop{entt::null};
+        int32_t                                        _inflate{};
+        int32_t                                        _spatial_cell{}; // 0 uses linked list bins
+        Entity                                         _edit{entt::null};
+        Entity                                         _drop{entt::null};
+        bool                                           _dirty_navmesh{};
+        bool                                           _iso_dirty{true};
     };
 
     void BeginDefaultMenu(const char* id, ImGui::CanvasParams& canvas);
@@ -6,6 +6,7 @@
 #include "utils/imguiline.hpp"
 #include "utils/lquadtree.hpp"
 #include "utils/lquery.hpp"
+#include "utils/triangulate.hpp"
 #include <rlgl.h>
 
 namespace fin
@@ -16,7 +17,7 @@ namespace fin
         struct Node
         {
             std::string_view   _name;
-            msg::Var           _points;
+            std::vector<Vec2f> _points;
             std::vector<Vec2f> _tringles;
             Rectf              _bbox;
             Texture2D::Ptr     _texture;
@@ -31,21 +32,22 @@ namespace fin
 
             uint32_t Size() const
             {
-                return _points.size() / 2;
+                return uint32_t(_points.size());
             }
 
             bool HitTest(float x, float y) const
             {
-                if (Size() < 3)
-                    return false; // Not a valid polygon
+                if (Size() < 3 || !_bbox.contains({x, y}))
+                    return false; // Not a valid polygon or outside bounds
 
-                bool   inside = false;
+                bool     inside = false;
                 uint32_t n      = Size();
+                const auto* pts = _points.data();
 
                 for (uint32_t i = 0, j = n - 1; i < n; j = i++)
                 {
-                    auto p1 = GetPoint(i);
-                    auto p2 = GetPoint(j);
+                    const Vec2f p1 = pts[i];
+                    const Vec2f p2 = pts[j];
 
                     // Check if point is exactly on a vertex
                     if ((p1.x == x && p1.y == y) || (p2.x == x && p2.y == y))
@@ -74,167 +76,72 @@ namespace fin
                 return inside;
             }
 
-            Vec2f GetPoint(uint32_t n) const
+            const Vec2f& GetPoint(uint32_t n) const
             {
-                auto self = const_cast<Node*>(this);
-                return {self->_points[n * 2].get(0.f), self->_points[n * 2 + 1].get(0.f)};
+                return _points[n];
             }
 
             void SetPoint(uint32_t n, Vec2f val)
             {
                 _need_update = true;
-                _points.set_item(n * 2, val.x);
-                _points.set_item(n * 2 + 1, val.y);
+                _points[n]   = val;
             }
 
             Node& Insert(Vec2f pt, int32_t n)
             {
                 _need_update = true;
-                if (uint32_t(n * 2) >= _points.size())
+                if (uint32_t(n) >= _points.size())
                 {
-                    _points.push_back(pt.x);
-                    _points.push_back(pt.y);
+                    _points.push_back(pt);
                 }
                 else
                 {
-                    n = n * 2;
-                    _points.insert(n, pt.x);
-                    _points.insert(n + 1, pt.y);
+                    _points.insert(_points.begin() + n, pt);
                 }
                 return *this;
             }
 
             int32_t Find(Vec2f pt, float radius)
             {
-                auto sze = _points.size();
-                for (uint32_t n = 0; n < sze; n += 2)
+                for (uint32_t n = 0; n < _points.size(); ++n)
                 {
-                    Vec2f pos(_points.get_item(n).get(0.f), _points.get_item(n + 1).get(0.f));
-                    if (pos.distance_squared(pt) <= (radius * radius))
+                    if (_points[n].distance_squared(pt) <= (radius * radius))
                     {
-                        return n / 2;
+                        return n;
                     }
                 }
                 return -1;
             }
 
-            void Triangulate()
+            void Triangulate(Triangulator& tri)
             {
                 _tringles.clear();
-                if (_points.size() < 6)
-                    return;
-
-                std::vector<Vec2f> vertices;
-                for (uint32_t n = 0; n < _points.size(); n += 2)
-                {
-                    vertices.emplace_back(_points.get_item(n).get(0.f), _points.get_item(n + 1).get(0.f));
-                }
-
-                auto fix_winding = [](std::vector<Vec2f>& verts)
-                {
-                    float area = 0;
-                    for (size_t i = 0; i < verts.size(); ++i)
-                    {
-                        size_t j = (i + 1) % verts.size();
-                        area += verts[i].x * verts[j].y - verts[j].x * verts[i].y;
-                    }
-                    if (area < 0)
-                        std::reverse(verts.begin(), verts.end());
-                };
-
-                auto is_convex = [](const Vec2f& a, const Vec2f& b, const Vec2f& c)
-                { return ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) >= 0.0f; };
-
-                auto point_in_triangle = [](const Vec2f& pt, const Vec2f& a, const Vec2f& b, const Vec2f& c)
-                {
-                    float d1      = (pt.x - b.x) * (a.y - b.y) - (a.x - b.x) * (pt.y - b.y);
-                    float d2      = (pt.x - c.x) * (b.y - c.y) - (b.x - c.x) * (pt.y - c.y);
-                    float d3      = (pt.x - a.x) * (c.y - a.y) - (c.x - a.x) * (pt.y - a.y);
-                    bool  has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
-                    bool  has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
-                    return !(has_neg && has_pos);
-                };
-
-                fix_winding(vertices);
-
-                std::vector<Vec2f> temp = vertices;
-                while (temp.size() >= 3)
-                {
-                    bool   ear_found = false;
-                    size_t n         = temp.size();
-
-                    for (size_t i = 0; i < n; ++i)
-                    {
-                        size_t prev = (i + n - 1) % n;
-                        size_t next = (i + 1) % n;
-
-                        Vec2f a = temp[prev];
-                        Vec2f b = temp[i];
-                        Vec2f c = temp[next];
-
-                        if (!is_convex(a, b, c))
-                            continue;
-
-                        bool ear = true;
-                        for (size_t j = 0; j < n; ++j)
-                        {
-                            if (j == prev || j == i || j == next)
-                                continue;
-                            if (point_in_triangle(temp[j], a, b, c))
-                            {
-                                ear = false;
-                                break;
-                            }
-                        }
-
-                        if (ear)
-                        {
-                            _tringles.push_back(a);
-                            _tringles.push_back(b);
-                            _tringles.push_back(c);
-                            temp.erase(temp.begin() + i);
-                            ear_found = true;
-                            break;
-                        }
-                    }
-
-                    if (!ear_found)
-                    {
-                        // Polygon is likely non-simple or malformed
-                        break;
-                    }
-                }
+                tri.run(_points, _tringles);
             }
 
-            void Update()
+            void Update(Triangulator& tri)
             {
                 _need_update = false;
                 _bbox        = {};
-                if (_points.size() >= 2)
+                if (!_points.empty())
                 {
+                    // Separate min and max passes over packed floats, the compiler vectorizes these
                     Region<float> reg(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
-                    for (uint32_t n = 0; n < _points.size(); n += 2)
+                    for (const auto& pt : _points)
                     {
-                        const float nxo = _points.get_item(n).get(0.f);
-                        const float nyo = _points.get_item(n + 1).get(0.f);
-
-                        if (nxo < reg.x1)
-                            reg.x1 = nxo;
-
-                        if (nxo > reg.x2)
-                            reg.x2 = nxo;
-
-                        if (nyo < reg.y1)
-                            reg.y1 = nyo;
-
-                        if (nyo > reg.y2)
-                            reg.y2 = nyo;
+                        reg.x1 = std::min(reg.x1, pt.x);
+                        reg.y1 = std::min(reg.y1, pt.y);
+                    }
+                    for (const auto& pt : _points)
+                    {
+                        reg.x2 = std::max(reg.x2, pt.x);
+                        reg.y2 = std::max(reg.y2, pt.y);
                     }
 
                     _bbox = reg.rect();
                 }
 
-                Triangulate();
+                Triangulate(tri);
             }
         };
 
@@ -248,6 +155,7 @@ namespace fin
         void Resize(Vec2f size) override
         {
             _spatial.resize({0, 0, size.width, size.height});
+            _geometry_dirty = true;
         }
 
         void Activate(const Rectf& region) override
@@ -269,7 +177,13 @@ namespace fin
             {
                 msg::Var item;
                 item.make_object(1);
-                item.set_item("p", node._points.clone());
+                msg::Var pts;
+                for (auto p : node._points)
+                {
+                    pts.push_back(p.x);
+                    pts.push_back(p.y);
+                }
+                item.set_item("p", pts);
                 item.set_item("i", node._index);
                 if (node._texture)
                 {
@@ -299,6 +213,7 @@ namespace fin
         {
             SceneLayer::Deserialize(ar);
             _spatial.clear();
+            _geometry_dirty = true;
 
             auto els = ar["items"];
             _max_index = ar["max_index"].get(0);
@@ -306,7 +221,12 @@ namespace fin
             for (auto& el : els.elements())
             {
                 Node nde;
-                nde._points = el["p"].clone();
+                auto pts = el["p"];
+                nde._points.reserve(pts.size() / 2);
+                for (uint32_t i = 0; i + 1 < pts.size(); i += 2)
+                {
+                    nde._points.emplace_back(pts[i].get(0.f), pts[i + 1].get(0.f));
+                }
                 auto idx    = el["i"];
                 if (idx.is_undefined())
                 {
@@ -328,7 +248,7 @@ namespace fin
                     nde._offset.y = el["ty"].get(0);
                 }
 
-                nde.Update();
+                nde.Update(_triangulator);
                 auto ndx = _spatial.insert(nde);
 
                 auto id = el["id"];
@@ -372,23 +292,18 @@ namespace fin
         {
             auto o = _spatial[obj];
             _spatial.remove(_spatial[obj]);
-            if (o._points.size() >= 2)
+            if (!o._points.empty())
             {
-                const float xo = o._points.get_item(0).get(0.f);
-                const float yo = o._points.get_item(1).get(0.f);
-
-                for (uint32_t n = 0; n < o._points.size(); n += 2)
+                const Vec2f delta = pos - o._points[0];
+                for (auto& pt : o._points)
                 {
-                    const float nxo = o._points.get_item(n).get(0.f) - xo + pos.x;
-                    const float nyo = o._points.get_item(n + 1).get(0.f) - yo + pos.y;
-
-                    o._points.set_item(n, nxo);
-                    o._points.set_item(n + 1, nyo);
+                    pt += delta;
                 }
             }
-            o.Update();
+            o.Update(_triangulator);
 
             _spatial.insert(o);
+            _geometry_dirty = true;
         }
 
         void RenderGrid(Renderer& dc)
@@ -420,45 +335,44 @@ namespace fin
         {
         }
 
-        void Render(Renderer& dc) override
+        void RebuildGeometry()
         {
-            if (IsHidden())
-                return;
+            _geometry_dirty = false;
 
-            rlDisableBackfaceCulling();
-            for (auto n : _spatial.get_active())
+            std::vector<int32_t> order;
+            order.reserve(_spatial.size());
+            for (int32_t n = 0; n < _spatial.size(); ++n)
             {
-                auto& nde = _spatial[n];
-                if (nde._texture)
-                {
-                    const auto center = nde._bbox.center();
-                    const auto width  = nde._texture->get_texture()->width;
-                    const auto height = nde._texture->get_texture()->height;
+                if (!_spatial.is_empty(n) && _spatial[n]._texture)
+                    order.push_back(n);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return _spatial[a]._index < _spatial[b]._index; });
 
-                    rlBegin(RL_QUADS);
-                    rlSetTexture(nde._texture->get_texture()->id);
-                    rlColor4ub(255, 255, 255, 255);
-                    rlNormal3f(0.0f, 0.0f, 1.0f);
+            const uint8_t white[4]{255, 255, 255, 255};
+            _geometry.begin(GeometryChunkVertices);
+            for (auto n : order)
+            {
+                auto&       nde = _spatial[n];
+                const auto* txt = nde._texture->get_texture();
+                _geometry.add_triangles(txt->id,
+                                        nde._tringles,
+                                        Vec2f(float(nde._offset.x), float(nde._offset.y)),
+                                        Vec2f(1.f / txt->width, 1.f / txt->height),
+                                        white);
+            }
+            _geometry.end();
+        }
 
-                    for (uint32_t n = 0; n < nde._tringles.size(); n+=3)
-                    {
-                        auto pt1 = nde._tringles[n];
-                        auto pt2 = nde._tringles[n + 1];
-                        auto pt3 = nde._tringles[n + 2];
-                        rlTexCoord2f((pt1.x - nde._offset.x) / width, (pt1.y - nde._offset.y) / height);
-                        rlVertex2f(pt1.x, pt1.y);
-                        rlTexCoord2f((pt2.x - nde._offset.x) / width, (pt2.y - nde._offset.y) / height);
-                        rlVertex2f(pt2.x, pt2.y);
-                        rlTexCoord2f((pt3.x - nde._offset.x) / width, (pt3.y - nde._offset.y) / height);
-                        rlVertex2f(pt3.x, pt3.y);
-                        rlTexCoord2f((pt3.x - nde._offset.x) / width, (pt3.y - nde._offset.y) / height);
-                        rlVertex2f(pt3.x, pt3.y);
-                    }
+        void Render(Renderer& dc) override
+        {
+            if (IsHidden())
+                return;
 
-                    rlEnd();
-                }
-            }
-            rlSetTexture(0);
+            if (_geometry_dirty)
+                RebuildGeometry();
+
+            dc.set_color(WHITE);
+            dc.render_geometry(_gpu, _geometry, _region);
         }
 
         bool ImguiWorkspaceMenu(ImGui::CanvasParams& canvas) override
@@ -570,7 +484,7 @@ namespace fin
                                 _spatial.remove(*SelectedRegion());
                                 _selected = -1;
                                 obj.SetPoint(_active_point, pt);
-                                obj.Update();
+                                obj.Update(_triangulator);
                                 _selected = _spatial.insert(obj);
                                 modified  = true;
                             }
@@ -588,7 +502,7 @@ namespace fin
                         auto obj = *reg;
                         _spatial.remove(*reg);
                         obj.Insert(mouse_pos, _active_point + 1);
-                        obj.Update();
+                        obj.Update(_triangulator);
                         _spatial.insert(obj);
                         _active_point = _active_point + 1;
                         modified      = true;
@@ -597,7 +511,7 @@ namespace fin
                     {
                         Node obj;
                         obj.Insert(mouse_pos, 0);
-                        obj.Update();
+                        obj.Update(_triangulator);
                         obj._index    = ++_max_index;
                         _selected     = _spatial.insert(obj);
                         _active_point = 0;
@@ -650,6 +564,7 @@ namespace fin
                 };
                 _spatial.for_each_node(cb);
             }
+            _geometry_dirty |= modified;
             return modified;
         }
 
@@ -683,7 +598,8 @@ namespace fin
 
                 if (modified)
                 {
-                    reg->Update();
+                    reg->Update(_triangulator);
+                    _geometry_dirty = true;
                 }
             }
             return modified;
@@ -737,7 +653,7 @@ namespace fin
                         {
                             if (el._name.empty())
                             {
-                                if (ImGui::Selectable(ImGui::FormatStr("Region [%d]", el._points.size() / 2), n == _selected))
+                                if (ImGui::Selectable(ImGui::FormatStr("Region [%d]", int(el._points.size())), n == _selected))
                                 {
                                     _selected = n;
                                 }
@@ -747,7 +663,7 @@ namespace fin
                                 if (ImGui::Selectable(ImGui::FormatStr("\"%.*s\" [%d]",
                                                                        static_cast<int>(el._name.size()),
                                                                        el._name.data(),
-                                                                       el._points.size() / 2),
+                                                                       int(el._points.size())),
                                                       n == _selected))
                                 {
                                     _selected = n;
@@ -771,7 +687,7 @@ namespace fin
                             {
                                 if (el._name.empty())
                                 {
-                                    if (ImGui::Selectable(ImGui::FormatStr("Region [%d]", el._points.size() / 2),
+                                    if (ImGui::Selectable(ImGui::FormatStr("Region [%d]", int(el._points.size())),
                                                           n == _selected))
                                     {
                                         _selected = n;
@@ -782,7 +698,7 @@ namespace fin
                                     if (ImGui::Selectable(ImGui::FormatStr("\"%.*s\" [%d]",
                                                                            static_cast<int>(el._name.size()),
                                                                            el._name.data(),
-                                                                           el._points.size() / 2),
+                                                                           int(el._points.size())),
                                                           n == _selected))
                                     {
                                         _selected = n;
@@ -797,10 +713,13 @@ namespace fin
 
             ImGui::EndChildFrame();
 
+            _geometry_dirty |= modified;
             return modified;
         }
 
     private:
+        static constexpr uint32_t GeometryChunkVertices = 4096; // triangle vertices culled together
+
         Node* SelectedRegion()
         {
             if (size_t(_selected) < size_t(_spatial.size()))
@@ -818,6 +737,10 @@ namespace fin
         int32_t                                                                              _selected     = -1;
         int32_t                                                                              _active_point = -1;
         bool                                                                                 _edit_region{true};
+        StaticGeometry                                                                       _geometry;
+        GeometryBuffer                                                                       _gpu;
+        bool                                                                                 _geometry_dirty{true};
+        Triangulator                                                                         _triangulator; // scratch of Node::Update, one per layer
     };
 
     SceneLayer* SceneLayer::CreateRegion()
@@ -6,6 +6,7 @@
 #include "utils/imguiline.hpp"
 #include "utils/lquadtree.hpp"
 #include "utils/lquery.hpp"
+#include "utils/static_index.hpp"
 
 namespace fin
 {
@@ -38,21 +39,35 @@ namespace fin
         void Destroy(int32_t n)
         {
             _spatial.remove(_spatial[n]);
+            _static_dirty = true;
         }
 
         void Resize(Vec2f size) override
         {
             _spatial.resize({0, 0, size.width, size.height});
+            _static_dirty = true;
         }
 
         void Activate(const Rectf& region) override
         {
             SceneLayer::Activate(region);
+            if (_static_dirty && GetScene()->GetMode() == SceneMode::Play)
+                RebuildStatic();
+
+            if (!_static_dirty)
+            {
+                _static.query(region, _active);
+                return;
+            }
+
+            // Edited since the last build, the quad tree stays exact while objects move around
             _spatial.activate(region);
             if (_sort_y)
-                _spatial.sort_active([&](int a, int b) { return _spatial[a]._bbox.y < _spatial[b]._bbox.y; });
+                _spatial.sort_active([&](int a, int b) { return DrawKey(_spatial[a]) < DrawKey(_spatial[b]); });
             else
                 _spatial.sort_active([&](int a, int b) { return _spatial[a]._index < _spatial[b]._index; });
+            auto els = _spatial.get_active();
+            _active.assign(els.begin(), els.end());
         }
 
         void MoveTo(int obj, Vec2f pos)
@@ -62,6 +77,44 @@ namespace fin
             o._bbox.x = pos.x;
             o._bbox.y = pos.y;
             _spatial.insert(o);
+            _static_dirty = true;
+        }
+
+        uint64_t DrawKey(const Node& nde) const
+        {
+            if (_sort_y)
+                return (uint64_t(StaticIndex::float_key(nde._bbox.y)) << 32) | nde._index;
+            return nde._index;
+        }
+
+        void RebuildStatic()
+        {
+            std::vector<StaticIndex::Item> items;
+            items.reserve(_spatial.size());
+            for (int32_t n = 0; n < _spatial.size(); ++n)
+            {
+                if (!_spatial.is_empty(n))
+                    items.push_back({_spatial[n]._bbox, DrawKey(_spatial[n]), n});
+            }
+
+            // Baked quads in draw order for the whole layer
+            std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) { return a.key < b.key; });
+            const uint8_t white[4]{255, 255, 255, 255};
+            _geometry.begin(StaticChunkVertices);
+            for (auto& it : items)
+            {
+                auto&       nde = _spatial[it.id];
+                const auto* txt = nde._sprite->GetTexture()->get_texture();
+                const auto& src = nde._sprite->GetRect();
+                _geometry.add_quad(txt->id,
+                                   nde._bbox,
+                                   Regionf(src.x / txt->width, src.y / txt->height, src.x2() / txt->width, src.y2() / txt->height),
+                                   white);
+            }
+            _geometry.end();
+
+            _static.build(items, StaticTileSize);
+            _static_dirty = false;
         }
 
         void Update(float dt) override
@@ -74,10 +127,17 @@ namespace fin
                 return;
 
             dc.set_color(WHITE);
-            for (auto n : _spatial.get_active())
+            if (!_static_dirty)
             {
-                auto& nde = _spatial[n];
-                dc.render_texture(nde._sprite->GetTexture()->get_texture(), nde._sprite->GetRect(), nde._bbox);
+                dc.render_geometry(_gpu, _geometry, _region);
+            }
+            else
+            {
+                for (auto n : _active)
+                {
+                    auto& nde = _spatial[n];
+                    dc.render_texture(nde._sprite->GetTexture()->get_texture(), nde._sprite->GetRect(), nde._bbox);
+                }
             }
 
             dc.set_color(WHITE);
@@ -132,6 +192,7 @@ namespace fin
                     _spatial.insert(nde);
                 }
             }
+            RebuildStatic();
         }
 
         int FindAt(Vec2f position)
@@ -141,9 +202,7 @@ namespace fin
 
         int FindActiveAt(Vec2f position)
         {
-            auto els = _spatial.get_active();
-
-            for (auto it = els.rbegin(); it != els.rend(); ++it)
+            for (auto it = _active.rbegin(); it != _active.rend(); ++it)
             {
                 const auto& spr = _spatial[*it];
 
@@ -236,7 +295,8 @@ namespace fin
                         _edit._index       = _max_index;
                         ++_max_index;
                         _spatial.insert(_edit);
-                        modified = true;
+                        _static_dirty = true;
+                        modified      = true;
                     }
                 }
 
@@ -281,7 +341,8 @@ namespace fin
         void ImguiSetup() override
         {
             SceneLayer::ImguiSetup();
-            ImGui::Checkbox("Sort by Y", &_sort_y);
+            if (ImGui::Checkbox("Sort by Y", &_sort_y))
+                _static_dirty = true;
         }
 
         bool ImguiUpdate(bool items) override
@@ -356,6 +417,7 @@ namespace fin
                         _edit._index       = _max_index;
                         ++_max_index;
                         _spatial.insert(_edit);
+                        _static_dirty = true;
                     }
                 }
             }
@@ -364,7 +426,7 @@ namespace fin
             {
                 if (gSettings.list_visible_items)
                 {
-                    for (auto n : _spatial.get_active())
+                    for (auto n : _active)
                     {
                         ImGui::PushID(n);
                         auto& el = _spatial[n];
@@ -414,11 +476,19 @@ namespace fin
         }
 
     private:
+        static constexpr float    StaticTileSize      = 512.f;
+        static constexpr uint32_t StaticChunkVertices = 4096; // baked quads culled together, 1024 per chunk
+
         LooseQuadTree<Node, decltype([](const Node& n) -> const Rectf& { return n._bbox; })> _spatial;
         Node                                                                                 _edit;
         int32_t                                                                              _select    = -1;
         uint32_t                                                                             _max_index = 0;
         bool                                                                                 _sort_y    = false;
+        StaticIndex                                                                          _static;
+        StaticGeometry                                                                       _geometry;
+        GeometryBuffer                                                                       _gpu;
+        std::vector<int32_t>                                                                 _active;
+        bool                                                                                 _static_dirty = true;
     };
 
     SceneLayer* SceneLayer::CreateSprite()
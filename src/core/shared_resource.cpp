@@ -1,6 +1,7 @@
 #include "shared_resource.hpp"
 #include <imstb_rectpack.h>
 #include <rlgl.h>
+#include <atomic>
 #include <utils/svstream.hpp>
 #include <utils/ini.hpp>
 
@@ -17,6 +18,7 @@ namespace fin
         std::unordered_map<std::string, std::weak_ptr<SoundSource>, std::string_hash, std::equal_to<>> _sounds;
         std::unordered_map<std::string, std::weak_ptr<Sprite2D>, std::string_hash, std::equal_to<>>    _sprites;
         std::unordered_map<std::string, std::weak_ptr<Shader2D>, std::string_hash, std::equal_to<>>    _shaders;
+        std::atomic<uint32_t>                                                                          _sprite_revision{};
     };
 
     static SharedResource _shared_res;
@@ -603,11 +605,13 @@ namespace fin
     Texture2D& Texture2D::operator=(Texture2D&& other) noexcept
     {
         std::swap(texture, other.texture);
+        Sprite2D::Invalidate();
         return *this;
     }
 
     void Texture2D::clear()
     {
+        Sprite2D::Invalidate();
         path.clear();
         bitmask.clear();
         if (texture.id)
@@ -735,6 +739,15 @@ namespace fin
         }
     }
 
+    void Texture2D::for_each_shared(const std::function<void(Texture2D&)>& fn)
+    {
+        for (auto& [pth, ref] : _shared_res._textures)
+        {
+            if (auto ptr = ref.lock())
+                fn(*ptr);
+        }
+    }
+
     Texture2D::Ptr Texture2D::load_shared(std::string_view pth)
     {
         auto it = _shared_res._textures.find(pth);
@@ -864,6 +877,7 @@ namespace fin
     {
         std::swap(_texture, s._texture);
         std::swap(_rect, s._rect);
+        Invalidate();
     }
 
     Sprite2D::~Sprite2D()
@@ -874,11 +888,13 @@ namespace fin
     {
         std::swap(_texture, s._texture);
         std::swap(_rect, s._rect);
+        Invalidate();
         return *this;
     }
 
     bool Sprite2D::LoadFromFile(std::string_view filePath)
     {
+        Invalidate();
         _path = filePath;
         int size = 0;
         if (auto* txt = LoadFileData(_path.c_str(), &size))
@@ -927,6 +943,7 @@ namespace fin
 
     void Sprite2D::ParseSprite(std::string_view content, std::string_view dir)
     {
+        Invalidate();
         std::ini_config cfg;
         if (cfg.parse_inplace(content))
         {
@@ -964,6 +981,7 @@ namespace fin
     bool Sprite2D::SetTexture(std::string_view filePath)
     {
         _texture = Texture2D::load_shared(filePath);
+        Invalidate();
         return !!_texture;
     }
 
@@ -985,6 +1003,7 @@ namespace fin
     void Sprite2D::SetRect(Rectf rc)
     {
         _rect = rc;
+        Invalidate();
     }
 
     Vec2f Sprite2D::GetSize() const
@@ -1000,6 +1019,17 @@ namespace fin
     void Sprite2D::SetOrigin(Vec2f o)
     {
         _origin = o;
+        Invalidate();
+    }
+
+    uint32_t Sprite2D::GetRevision()
+    {
+        return _shared_res._sprite_revision.load(std::memory_order_relaxed);
+    }
+
+    void Sprite2D::Invalidate()
+    {
+        _shared_res._sprite_revision.fetch_add(1, std::memory_order_relaxed);
     }
 
     bool Sprite2D::IsAlphaVisible(int x, int y) const
@@ -113,6 +113,8 @@ namespace fin
         bool is_alpha_visible(uint32_t x, uint32_t y) const;
 
         static Ptr load_shared(std::string_view pth);
+        /// Calls fn for every texture currently alive from load_shared.
+        static void for_each_shared(const std::function<void(Texture2D&)>& fn);
         explicit   operator bool() const;
     };
 
@@ -293,6 +295,10 @@ namespace fin
 
         static Ptr LoadShared(std::string_view pth);
 
+        /// Bumped whenever any sprite or texture changes, draw data cached against it goes stale.
+        static uint32_t GetRevision();
+        static void     Invalidate();
+
         static bool CreateTextureAtlas(const std::string& folderPath,
                                        const std::string& atlasName,
                                        int                maxAtlasWidth  = 2048,
@@ -0,0 +1,544 @@
+#include "software_backend.hpp"
+#include "shared_resource.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace fin
+{
+    // a * b / 255 rounded, exact for 8 bit inputs
+    static inline uint32_t Mul8(uint32_t a, uint32_t b)
+    {
+        const uint32_t x = a * b + 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // Mul8 on the two 8 bit lanes of x & 0x00ff00ff
+    static inline uint32_t MulLanes(uint32_t x, uint32_t f)
+    {
+        x = x * f + 0x00800080u;
+        return ((x + ((x >> 8) & 0x00ff00ffu)) >> 8) & 0x00ff00ffu;
+    }
+
+    static inline uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    static inline uint32_t Pack(Color c)
+    {
+        return Pack(c.r, c.g, c.b, c.a);
+    }
+
+    static inline uint32_t Channel(uint32_t c, int32_t n)
+    {
+        return (c >> (n * 8)) & 0xff;
+    }
+
+    static inline uint32_t Modulate(uint32_t texel, uint32_t color)
+    {
+        return Pack(Mul8(Channel(texel, 0), Channel(color, 0)),
+                    Mul8(Channel(texel, 1), Channel(color, 1)),
+                    Mul8(Channel(texel, 2), Channel(color, 2)),
+                    Mul8(Channel(texel, 3), Channel(color, 3)));
+    }
+
+    static inline int32_t Wrap(int32_t v, int32_t size)
+    {
+        v %= size;
+        return v < 0 ? v + size : v;
+    }
+
+    void SoftwareBackend::begin(int32_t width, int32_t height, Color clear)
+    {
+        _width  = std::max(width, 0);
+        _height = std::max(height, 0);
+        _cols   = (_width + TileSize - 1) / TileSize;
+        _rows   = (_height + TileSize - 1) / TileSize;
+        _pixels.assign(size_t(_width) * _height, Pack(clear));
+        _bins.resize(size_t(_cols) * _rows);
+    }
+
+    void SoftwareBackend::set_camera(const Camera2D& camera)
+    {
+        _camera       = camera;
+        const float r = camera.rotation * DEG2RAD;
+        const float c = std::cos(r) * camera.zoom;
+        const float s = std::sin(r) * camera.zoom;
+        _axis_x       = {c, s};
+        _axis_y       = {-s, c};
+    }
+
+    void SoftwareBackend::set_texture(uint32_t id, const Image& pixels)
+    {
+        if (!id || !pixels.data || pixels.width <= 0 || pixels.height <= 0)
+            return;
+
+        auto&  tex    = _textures[id];
+        Color* colors = LoadImageColors(pixels);
+        tex.width     = pixels.width;
+        tex.height    = pixels.height;
+        tex.data.resize(size_t(pixels.width) * pixels.height);
+        for (size_t n = 0; n < tex.data.size(); ++n)
+            tex.data[n] = Pack(colors[n]);
+        UnloadImageColors(colors);
+    }
+
+    void SoftwareBackend::set_texture(uint32_t id, const Surface& pixels)
+    {
+        set_texture(id, *pixels.get_surface());
+    }
+
+    void SoftwareBackend::set_texture(const Texture2D& texture)
+    {
+        const auto* txt = texture.get_texture();
+        if (!txt->id)
+            return;
+
+        Image img = LoadImageFromTexture(*txt);
+        set_texture(txt->id, img);
+        UnloadImage(img);
+    }
+
+    bool SoftwareBackend::has_texture(uint32_t id) const
+    {
+        return _textures.contains(id);
+    }
+
+    void SoftwareBackend::remove_texture(uint32_t id)
+    {
+        _textures.erase(id);
+    }
+
+    Vec2i SoftwareBackend::get_size() const
+    {
+        return {_width, _height};
+    }
+
+    Color SoftwareBackend::get_pixel(int32_t x, int32_t y) const
+    {
+        const uint32_t c = _pixels[size_t(y) * _width + x];
+        return {uint8_t(Channel(c, 0)), uint8_t(Channel(c, 1)), uint8_t(Channel(c, 2)), uint8_t(Channel(c, 3))};
+    }
+
+    std::span<const uint32_t> SoftwareBackend::pixels() const
+    {
+        return _pixels;
+    }
+
+    bool SoftwareBackend::read(Surface& out) const
+    {
+        if (_pixels.empty())
+            return false;
+        return out.load_from_pixels(_width, _height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, _pixels.data());
+    }
+
+    bool SoftwareBackend::find_texture(uint32_t id, const Texels*& out) const
+    {
+        out = nullptr;
+        if (!id)
+            return true;
+
+        auto it = _textures.find(id);
+        if (it == _textures.end())
+            return false;
+        out = &it->second;
+        return true;
+    }
+
+    Vec2f SoftwareBackend::transform(float x, float y) const
+    {
+        const float dx = x - _camera.target.x;
+        const float dy = y - _camera.target.y;
+        return {_camera.offset.x + dx * _axis_x.x + dy * _axis_y.x, _camera.offset.y + dx * _axis_x.y + dy * _axis_y.y};
+    }
+
+    void SoftwareBackend::add(const Primitive& prim, const Regionf& bounds)
+    {
+        const int32_t x1 = std::max(int32_t(std::floor(bounds.x1)), 0);
+        const int32_t y1 = std::max(int32_t(std::floor(bounds.y1)), 0);
+        const int32_t x2 = std::min(int32_t(std::ceil(bounds.x2)), _width);
+        const int32_t y2 = std::min(int32_t(std::ceil(bounds.y2)), _height);
+        if (x1 >= x2 || y1 >= y2)
+            return;
+
+        const uint32_t index = uint32_t(_primitives.size());
+        _primitives.push_back(prim);
+        for (int32_t y = y1 / TileSize; y <= (y2 - 1) / TileSize; ++y)
+        {
+            for (int32_t x = x1 / TileSize; x <= (x2 - 1) / TileSize; ++x)
+                _bins[y * _cols + x].push_back(index);
+        }
+    }
+
+    void SoftwareBackend::add_rect(const Texels* tex, Vec2f p0, Vec2f p1, Vec2f uv0, Vec2f uv1, uint32_t color)
+    {
+        // Flipped destinations mirror the texture instead
+        if (p1.x < p0.x)
+        {
+            std::swap(p0.x, p1.x);
+            std::swap(uv0.x, uv1.x);
+        }
+        if (p1.y < p0.y)
+        {
+            std::swap(p0.y, p1.y);
+            std::swap(uv0.y, uv1.y);
+        }
+
+        Primitive prim;
+        prim.rect     = true;
+        prim.texture  = tex;
+        prim.pos[0]   = p0;
+        prim.pos[1]   = p1;
+        prim.uv[0]    = uv0;
+        prim.uv[1]    = uv1;
+        prim.color[0] = color;
+        add(prim, {p0.x, p0.y, p1.x, p1.y});
+    }
+
+    void SoftwareBackend::add_triangle(const Texels* tex, const Vec2f (&pos)[3], const Vec2f (&uv)[3], const uint32_t (&color)[3])
+    {
+        Primitive prim;
+        prim.rect    = false;
+        prim.texture = tex;
+        for (int32_t n = 0; n < 3; ++n)
+        {
+            prim.pos[n]   = pos[n];
+            prim.uv[n]    = uv[n];
+            prim.color[n] = color[n];
+        }
+        add(prim,
+            {std::min({pos[0].x, pos[1].x, pos[2].x}),
+             std::min({pos[0].y, pos[1].y, pos[2].y}),
+             std::max({pos[0].x, pos[1].x, pos[2].x}),
+             std::max({pos[0].y, pos[1].y, pos[2].y})});
+    }
+
+    void SoftwareBackend::add_line(Vec2f from, Vec2f to, uint32_t color)
+    {
+        // One pixel wide quad along the line, extended by half a pixel at both ends
+        const Vec2f d   = to - from;
+        const float len = std::sqrt(d.x * d.x + d.y * d.y);
+        const Vec2f t   = len > 1e-6f ? d * (0.5f / len) : Vec2f(0.5f, 0);
+        const Vec2f n(-t.y, t.x);
+
+        const Vec2f a = from - t + n;
+        const Vec2f b = from - t - n;
+        const Vec2f c = to + t - n;
+        const Vec2f e = to + t + n;
+        const Vec2f uv[3]{};
+        const uint32_t clr[3]{color, color, color};
+        add_triangle(nullptr, {a, b, c}, uv, clr);
+        add_triangle(nullptr, {a, c, e}, uv, clr);
+    }
+
+    void SoftwareBackend::submit(const CommandList& list)
+    {
+        if (_pixels.empty())
+            return;
+
+        // Screen space primitives binned in submission order
+        _primitives.clear();
+        const bool axis_aligned = _axis_x.y == 0 && _axis_y.x == 0;
+        const auto vertices     = list.vertices();
+        for (auto& cmd : list.commands())
+        {
+            const Texels* tex = nullptr;
+            switch (cmd.op)
+            {
+            case RenderOp::Quads:
+            {
+                if (!find_texture(cmd.texture, tex))
+                    break;
+
+                for (auto* v = &vertices[cmd.first], *end = v + cmd.count; v != end; v += 4)
+                {
+                    const uint32_t clr = Pack(v[0].r, v[0].g, v[0].b, v[0].a);
+                    if (axis_aligned)
+                    {
+                        add_rect(tex, transform(v[0].x, v[0].y), transform(v[2].x, v[2].y), {v[0].u, v[0].v}, {v[2].u, v[2].v}, clr);
+                        continue;
+                    }
+
+                    const Vec2f p[4]{transform(v[0].x, v[0].y), transform(v[1].x, v[1].y), transform(v[2].x, v[2].y), transform(v[3].x, v[3].y)};
+                    const uint32_t c[3]{clr, clr, clr};
+                    add_triangle(tex, {p[0], p[1], p[2]}, {{v[0].u, v[0].v}, {v[1].u, v[1].v}, {v[2].u, v[2].v}}, c);
+                    add_triangle(tex, {p[0], p[2], p[3]}, {{v[0].u, v[0].v}, {v[2].u, v[2].v}, {v[3].u, v[3].v}}, c);
+                }
+                break;
+            }
+            case RenderOp::Triangles:
+            {
+                if (!find_texture(cmd.texture, tex))
+                    break;
+
+                for (auto* v = &vertices[cmd.first], *end = v + cmd.count; v != end; v += 3)
+                {
+                    add_triangle(tex,
+                                 {transform(v[0].x, v[0].y), transform(v[1].x, v[1].y), transform(v[2].x, v[2].y)},
+                                 {{v[0].u, v[0].v}, {v[1].u, v[1].v}, {v[2].u, v[2].v}},
+                                 {Pack(v[0].r, v[0].g, v[0].b, v[0].a), Pack(v[1].r, v[1].g, v[1].b, v[1].a), Pack(v[2].r, v[2].g, v[2].b, v[2].a)});
+                }
+                break;
+            }
+            case RenderOp::Lines:
+            {
+                for (auto* v = &vertices[cmd.first], *end = v + cmd.count; v != end; v += 2)
+                    add_line(transform(v[0].x, v[0].y), transform(v[1].x, v[1].y), Pack(v[0].r, v[0].g, v[0].b, v[0].a));
+                break;
+            }
+            case RenderOp::Geometry:
+            {
+                auto&          geo  = list.geometry(cmd.first);
+                const uint32_t tint = Pack(geo.color);
+                geo.geometry->query(geo.view, _chunks);
+                for (auto* chunk : _chunks)
+                {
+                    for (auto& batch : chunk->batches)
+                    {
+                        if (!find_texture(batch.texture, tex))
+                            continue;
+
+                        for (uint32_t i = batch.first; i + 3 <= batch.first + batch.count; i += 3)
+                        {
+                            const GeometryVertex* v[3]{&chunk->vertices[chunk->indices[i]],
+                                                       &chunk->vertices[chunk->indices[i + 1]],
+                                                       &chunk->vertices[chunk->indices[i + 2]]};
+                            Vec2f pos[3], uv[3];
+                            uint32_t clr[3];
+                            for (int32_t n = 0; n < 3; ++n)
+                            {
+                                pos[n] = transform(v[n]->x, v[n]->y);
+                                uv[n]  = {v[n]->u, v[n]->v};
+                                clr[n] = Modulate(Pack(v[n]->r, v[n]->g, v[n]->b, v[n]->a), tint);
+                            }
+                            add_triangle(tex, pos, uv, clr);
+                        }
+                    }
+                }
+                break;
+            }
+            case RenderOp::Text:
+            case RenderOp::Shader:
+                break;
+            }
+        }
+
+        if (_primitives.empty())
+            return;
+
+        // Tiles own disjoint pixels, each replays its bin in order
+        ThreadPool::Get().parallel_for(_cols * _rows,
+                                       1,
+                                       [this](int32_t begin, int32_t end)
+                                       {
+                                           for (int32_t t = begin; t < end; ++t)
+                                           {
+                                               auto& bin = _bins[t];
+                                               if (bin.empty())
+                                                   continue;
+
+                                               const int32_t x = (t % _cols) * TileSize;
+                                               const int32_t y = (t / _cols) * TileSize;
+                                               const Regioni clip(x, y, std::min(x + TileSize, _width), std::min(y + TileSize, _height));
+                                               for (auto idx : bin)
+                                               {
+                                                   const auto& prim = _primitives[idx];
+                                                   if (prim.rect)
+                                                       draw_rect(prim, clip);
+                                                   else
+                                                       draw_triangle(prim, clip);
+                                               }
+                                               bin.clear();
+                                           }
+                                       });
+    }
+
+    void SoftwareBackend::blend_span(uint32_t* dst, const uint32_t* src, int32_t count)
+    {
+        // Straight alpha over as on the scene canvas, red and blue then green and alpha share one multiply;
+        // plain integer code without branches, so the compiler vectorizes it
+        for (int32_t i = 0; i < count; ++i)
+        {
+            const uint32_t s  = src[i];
+            const uint32_t d  = dst[i];
+            const uint32_t a  = s >> 24;
+            const uint32_t ia = 255 - a;
+            const uint32_t rb = MulLanes(s & 0x00ff00ffu, a) + MulLanes(d & 0x00ff00ffu, ia);
+            const uint32_t ga = MulLanes(((s >> 8) & 0xffu) | 0x00ff0000u, a) + MulLanes((d >> 8) & 0x00ff00ffu, ia);
+            dst[i]            = rb | (ga << 8);
+        }
+    }
+
+    void SoftwareBackend::draw_rect(const Primitive& prim, const Regioni& clip)
+    {
+        // Pixels whose centers lie inside, the right and bottom edges are exclusive
+        const Vec2f   p0 = prim.pos[0];
+        const Vec2f   p1 = prim.pos[1];
+        const int32_t x1 = std::max(clip.x1, int32_t(std::ceil(p0.x - 0.5f)));
+        const int32_t y1 = std::max(clip.y1, int32_t(std::ceil(p0.y - 0.5f)));
+        const int32_t x2 = std::min(clip.x2, int32_t(std::ceil(p1.x - 0.5f)));
+        const int32_t y2 = std::min(clip.y2, int32_t(std::ceil(p1.y - 0.5f)));
+        if (x1 >= x2 || y1 >= y2)
+            return;
+
+        uint32_t       span[TileSize];
+        const int32_t  count = x2 - x1;
+        const uint32_t color = prim.color[0];
+        const auto*    tex   = prim.texture;
+        if (!tex)
+        {
+            std::fill_n(span, count, color);
+            for (int32_t y = y1; y < y2; ++y)
+                blend_span(&_pixels[size_t(y) * _width + x1], span, count);
+            return;
+        }
+
+        // Texel coordinates step linearly, u in 16.16 fixed point
+        const float   du     = (prim.uv[1].x - prim.uv[0].x) * tex->width / (p1.x - p0.x);
+        const float   dv     = (prim.uv[1].y - prim.uv[0].y) * tex->height / (p1.y - p0.y);
+        const float   u0     = prim.uv[0].x * tex->width + (x1 + 0.5f - p0.x) * du;
+        const int64_t ustart = int64_t(std::floor(u0 * 65536.f));
+        const int64_t ustep  = int64_t(du * 65536.f);
+        const int64_t ulast  = ustart + ustep * (count - 1);
+        const bool    inside = std::min(ustart, ulast) >= 0 && (std::max(ustart, ulast) >> 16) < tex->width;
+
+        int32_t last = -1;
+        for (int32_t y = y1; y < y2; ++y)
+        {
+            const int32_t ty = Wrap(int32_t(std::floor(prim.uv[0].y * tex->height + (y + 0.5f - p0.y) * dv)), tex->height);
+
+            // Magnified rows often sample the same texel row as the one above
+            if (ty != last)
+            {
+                last                = ty;
+                const uint32_t* row = &tex->data[size_t(ty) * tex->width];
+                int64_t         u   = ustart;
+                if (inside)
+                {
+                    for (int32_t i = 0; i < count; ++i, u += ustep)
+                        span[i] = row[u >> 16];
+                }
+                else
+                {
+                    for (int32_t i = 0; i < count; ++i, u += ustep)
+                        span[i] = row[Wrap(int32_t(u >> 16), tex->width)];
+                }
+
+                if (color != 0xffffffffu)
+                {
+                    for (int32_t i = 0; i < count; ++i)
+                        span[i] = Modulate(span[i], color);
+                }
+            }
+            blend_span(&_pixels[size_t(y) * _width + x1], span, count);
+        }
+    }
+
+    void SoftwareBackend::draw_triangle(const Primitive& prim, const Regioni& clip)
+    {
+        Vec2f p[3]{prim.pos[0], prim.pos[1], prim.pos[2]};
+        int32_t order[3]{0, 1, 2};
+        float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+        if (area == 0)
+            return;
+        if (area < 0)
+        {
+            std::swap(p[1], p[2]);
+            std::swap(order[1], order[2]);
+            area = -area;
+        }
+
+        // Edge n is opposite vertex n, w = a * x + b * y + c is its barycentric weight times area
+        float a[3], b[3], c[3];
+        for (int32_t n = 0; n < 3; ++n)
+        {
+            const Vec2f& from = p[(n + 1) % 3];
+            const Vec2f& to   = p[(n + 2) % 3];
+            a[n]              = from.y - to.y;
+            b[n]              = to.x - from.x;
+            c[n]              = -a[n] * from.x - b[n] * from.y;
+        }
+
+        // Attributes as planes over the screen, texel units for uv
+        const auto*   tex   = prim.texture;
+        const Vec2f   scale = tex ? Vec2f(float(tex->width), float(tex->height)) : Vec2f(0, 0);
+        const float   inv   = 1.f / area;
+        float         attr[6][3]; // u, v, r, g, b, a per vertex
+        for (int32_t n = 0; n < 3; ++n)
+        {
+            const int32_t src = order[n];
+            attr[0][n]        = prim.uv[src].x * scale.x;
+            attr[1][n]        = prim.uv[src].y * scale.y;
+            for (int32_t ch = 0; ch < 4; ++ch)
+                attr[2 + ch][n] = float(Channel(prim.color[src], ch));
+        }
+        const bool solid = !tex && prim.color[0] == prim.color[1] && prim.color[0] == prim.color[2];
+
+        const int32_t y1 = std::max(clip.y1, int32_t(std::floor(std::min({p[0].y, p[1].y, p[2].y}))));
+        const int32_t y2 = std::min(clip.y2, int32_t(std::ceil(std::max({p[0].y, p[1].y, p[2].y}))));
+
+        uint32_t span[TileSize];
+        if (solid)
+            std::fill_n(span, TileSize, prim.color[0]);
+
+        for (int32_t y = y1; y < y2; ++y)
+        {
+            // Span of pixel centers inside all edges; left edges include the boundary, right ones do not,
+            // so triangles sharing an edge never blend a pixel twice
+            const float cy = y + 0.5f;
+            int32_t     x1 = clip.x1;
+            int32_t     x2 = clip.x2;
+            for (int32_t n = 0; n < 3 && x1 < x2; ++n)
+            {
+                const float k = b[n] * cy + c[n];
+                if (a[n] > 0)
+                    x1 = std::max(x1, int32_t(std::ceil(-k / a[n] - 0.5f)));
+                else if (a[n] < 0)
+                    x2 = std::min(x2, int32_t(std::ceil(-k / a[n] - 0.5f)));
+                else if (k < 0 || (k == 0 && b[n] < 0))
+                    x2 = x1;
+            }
+            if (x1 >= x2)
+                continue;
+
+            const int32_t count = x2 - x1;
+            uint32_t*     dst   = &_pixels[size_t(y) * _width + x1];
+            if (solid)
+            {
+                blend_span(dst, span, count);
+                continue;
+            }
+
+            const float cx = x1 + 0.5f;
+            float       val[6], step[6];
+            for (int32_t i = 0; i < 6; ++i)
+            {
+                val[i]  = 0;
+                step[i] = 0;
+                for (int32_t n = 0; n < 3; ++n)
+                {
+                    val[i] += (a[n] * cx + b[n] * cy + c[n]) * inv * attr[i][n];
+                    step[i] += a[n] * inv * attr[i][n];
+                }
+            }
+
+            for (int32_t i = 0; i < count; ++i)
+            {
+                const uint32_t clr = Pack(uint32_t(std::clamp(val[2] + step[2] * i, 0.f, 255.f)),
+                                          uint32_t(std::clamp(val[3] + step[3] * i, 0.f, 255.f)),
+                                          uint32_t(std::clamp(val[4] + step[4] * i, 0.f, 255.f)),
+                                          uint32_t(std::clamp(val[5] + step[5] * i, 0.f, 255.f)));
+                if (tex)
+                {
+                    const int32_t tx = Wrap(int32_t(std::floor(val[0] + step[0] * i)), tex->width);
+                    const int32_t ty = Wrap(int32_t(std::floor(val[1] + step[1] * i)), tex->height);
+                    span[i]          = Modulate(tex->data[size_t(ty) * tex->width + tx], clr);
+                }
+                else
+                {
+                    span[i] = clr;
+                }
+            }
+            blend_span(dst, span, count);
+        }
+    }
+} // namespace fin
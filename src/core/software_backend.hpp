@@ -0,0 +1,82 @@
+#pragma once
+
+#include "renderer.hpp"
+
+namespace fin
+{
+    class Surface;
+    class Texture2D;
+
+    /// Rasterizes command lists on the CPU, for thumbnails and reference images without a GL context.
+    /// Primitives are transformed by the camera and binned into square tiles; tiles rasterize on the
+    /// thread pool and each one replays its primitives in submission order, so blending follows the
+    /// list exactly. Textures are sampled nearest with wrap from CPU copies registered by id, texture
+    /// 0 is plain white and unregistered ones are skipped. Text and shaders are ignored.
+    /// Scene::RenderThumbnail feeds a whole scene through it, e.g. `finite /scene=assets/intro.map /thumbnail=intro.png`.
+    class SoftwareBackend : public RenderBackend
+    {
+    public:
+        static constexpr int32_t TileSize = 64; // pixels per tile side
+
+        /// Resizes the target and clears it.
+        void begin(int32_t width, int32_t height, Color clear);
+        /// Same transform as BeginMode2D with this camera.
+        void set_camera(const Camera2D& camera);
+        /// CPU copy of the pixels of texture id, converted to rgba.
+        void set_texture(uint32_t id, const Image& pixels);
+        void set_texture(uint32_t id, const Surface& pixels);
+        /// CPU copy read back from the GPU, needs the GL context the texture was loaded in.
+        void set_texture(const Texture2D& texture);
+        bool has_texture(uint32_t id) const;
+        void remove_texture(uint32_t id);
+
+        void submit(const CommandList& list) override;
+
+        Vec2i                     get_size() const;
+        Color                     get_pixel(int32_t x, int32_t y) const;
+        /// Rows top down, rgba packed with red in the low byte.
+        std::span<const uint32_t> pixels() const;
+        bool                      read(Surface& out) const;
+
+    private:
+        struct Texels
+        {
+            int32_t               width{};
+            int32_t               height{};
+            std::vector<uint32_t> data;
+        };
+
+        struct Primitive
+        {
+            bool          rect;    // axis aligned quad, pos and uv hold the top left and bottom right corners
+            const Texels* texture; // nullptr is white
+            Vec2f         pos[3];
+            Vec2f         uv[3];
+            uint32_t      color[3];
+        };
+
+        Vec2f transform(float x, float y) const;
+        void  add_rect(const Texels* tex, Vec2f p0, Vec2f p1, Vec2f uv0, Vec2f uv1, uint32_t color);
+        void  add_triangle(const Texels* tex, const Vec2f (&pos)[3], const Vec2f (&uv)[3], const uint32_t (&color)[3]);
+        void  add_line(Vec2f from, Vec2f to, uint32_t color);
+        void  add(const Primitive& prim, const Regionf& bounds);
+        bool  find_texture(uint32_t id, const Texels*& out) const;
+        void  draw_rect(const Primitive& prim, const Regioni& clip);
+        void  draw_triangle(const Primitive& prim, const Regioni& clip);
+
+        static void blend_span(uint32_t* dst, const uint32_t* src, int32_t count);
+
+        std::unordered_map<uint32_t, Texels> _textures;
+        std::vector<uint32_t>                _pixels;
+        std::vector<Primitive>               _primitives;
+        std::vector<std::vector<uint32_t>>   _bins; // primitive indices per tile in submission order
+        std::vector<const GeometryChunk*>    _chunks; // scratch, geometry chunks in view
+        Camera2D                             _camera{{}, {}, 0, 1.f};
+        Vec2f                                _axis_x{1, 0}; // screen step of one world unit along x
+        Vec2f                                _axis_y{0, 1};
+        int32_t                              _width{};
+        int32_t                              _height{};
+        int32_t                              _cols{};
+        int32_t                              _rows{};
+    };
+} // namespace fin
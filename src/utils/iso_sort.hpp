@@ -0,0 +1,224 @@
+#pragma once
+
+#include "api/math_utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace fin
+{
+    /// Back to front draw order of isometric objects.
+    /// Overlaps are only tested between objects sharing a bin of a uniform grid, the back edges of all
+    /// objects are pooled in one array and depth comes from an iterative walk that ignores edges closing
+    /// a cycle. Objects of equal depth keep their pool order.
+    /// T provides _bbox, _origin, _depth, _depth_active, _back_begin and _back_end.
+    template <typename T>
+    class IsoSort
+    {
+    public:
+        /// Fills order, which holds pool.size() entries, with the objects of pool back to front.
+        void sort(std::span<T> pool, std::span<T*> order);
+
+    private:
+        void update_edges(std::span<T> pool);
+        void sort_depth(std::span<T> pool, std::span<T*> order);
+
+        std::vector<uint32_t>                      _edges;     // pooled back edges, pool indices
+        std::vector<uint32_t>                      _bin_start; // grid bin ranges / depth histogram
+        std::vector<uint32_t>                      _bin_items; // pool indices per grid bin
+        std::vector<std::pair<uint32_t, uint32_t>> _pairs;     // (front, back) overlaps
+        std::vector<std::pair<uint32_t, uint32_t>> _stack;     // (object, next edge) for the depth walk
+    };
+
+    template <typename T>
+    inline void IsoSort<T>::sort(std::span<T> pool, std::span<T*> order)
+    {
+        for (auto& obj : pool)
+        {
+            obj._depth        = 0;
+            obj._depth_active = false;
+            obj._back_begin   = 0;
+            obj._back_end     = 0;
+        }
+
+        if (pool.size() > 1)
+        {
+            update_edges(pool);
+            sort_depth(pool, order);
+        }
+        else if (pool.size() == 1)
+        {
+            order[0] = &pool[0];
+        }
+    }
+
+    template <typename T>
+    inline void IsoSort<T>::update_edges(std::span<T> pool)
+    {
+        constexpr float   MinBinSize = 32.f;
+        constexpr int32_t MaxBins    = 256; // per axis
+
+        const uint32_t count = uint32_t(pool.size());
+
+        // Uniform grid over the objects, bins about the size of an average object
+        Regionf bounds = pool[0]._bbox;
+        float   extent = 0;
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            const auto& bb = pool[n]._bbox;
+            bounds.x1      = std::min(bounds.x1, bb.x1);
+            bounds.y1      = std::min(bounds.y1, bb.y1);
+            bounds.x2      = std::max(bounds.x2, bb.x2);
+            bounds.y2      = std::max(bounds.y2, bb.y2);
+            extent += std::max(bb.x2 - bb.x1, bb.y2 - bb.y1);
+        }
+
+        const float bin_size = std::max({extent / count,
+                                         MinBinSize,
+                                         (bounds.x2 - bounds.x1) / MaxBins,
+                                         (bounds.y2 - bounds.y1) / MaxBins});
+        const float   inv_size = 1.f / bin_size;
+        const int32_t cols     = std::min(int32_t((bounds.x2 - bounds.x1) * inv_size) + 1, MaxBins + 1);
+        const int32_t rows     = std::min(int32_t((bounds.y2 - bounds.y1) * inv_size) + 1, MaxBins + 1);
+
+        auto bin_col = [&](float x) { return std::clamp(int32_t((x - bounds.x1) * inv_size), 0, cols - 1); };
+        auto bin_row = [&](float y) { return std::clamp(int32_t((y - bounds.y1) * inv_size), 0, rows - 1); };
+
+        // Bin objects, two passes over a counting layout
+        _bin_start.assign(size_t(cols) * rows + 1, 0);
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            const auto& bb = pool[n]._bbox;
+            for (int32_t r = bin_row(bb.y1), r2 = bin_row(bb.y2); r <= r2; ++r)
+                for (int32_t c = bin_col(bb.x1), c2 = bin_col(bb.x2); c <= c2; ++c)
+                    ++_bin_start[r * cols + c + 1];
+        }
+        for (size_t n = 1; n < _bin_start.size(); ++n)
+            _bin_start[n] += _bin_start[n - 1];
+
+        _bin_items.resize(_bin_start.back());
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            const auto& bb = pool[n]._bbox;
+            for (int32_t r = bin_row(bb.y1), r2 = bin_row(bb.y2); r <= r2; ++r)
+                for (int32_t c = bin_col(bb.x1), c2 = bin_col(bb.x2); c <= c2; ++c)
+                    _bin_items[_bin_start[r * cols + c]++] = n;
+        }
+        for (size_t n = _bin_start.size() - 1; n > 0; --n)
+            _bin_start[n] = _bin_start[n - 1];
+        _bin_start[0] = 0;
+
+        // Overlaps, a pair sharing several bins is only tested in the bin
+        // holding the top left corner of the intersection
+        _pairs.clear();
+        for (int32_t bin = 0; bin < cols * rows; ++bin)
+        {
+            const uint32_t begin = _bin_start[bin];
+            const uint32_t end   = _bin_start[bin + 1];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const uint32_t ia = _bin_items[i];
+                const auto*    a  = &pool[ia];
+                for (uint32_t j = i + 1; j < end; ++j)
+                {
+                    const uint32_t ib = _bin_items[j];
+                    const auto*    b  = &pool[ib];
+                    if (!a->_bbox.intersects(b->_bbox))
+                        continue;
+
+                    const float cx = std::max(a->_bbox.x1, b->_bbox.x1);
+                    const float cy = std::max(a->_bbox.y1, b->_bbox.y1);
+                    if (bin_row(cy) * cols + bin_col(cx) != bin)
+                        continue;
+
+                    // Check if b is above iso line
+                    if (b->_origin.compare(a->_origin) >= 0)
+                        _pairs.emplace_back(ia, ib);
+                    else
+                        _pairs.emplace_back(ib, ia);
+                }
+            }
+        }
+
+        // Pack back edges per object
+        for (auto& [front, back] : _pairs)
+            ++pool[front]._back_end;
+
+        uint32_t offset = 0;
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            auto& obj       = pool[n];
+            obj._back_begin = offset;
+            offset += obj._back_end;
+            obj._back_end = obj._back_begin;
+        }
+
+        _edges.resize(offset);
+        for (auto& [front, back] : _pairs)
+            _edges[pool[front]._back_end++] = back;
+    }
+
+    template <typename T>
+    inline void IsoSort<T>::sort_depth(std::span<T> pool, std::span<T*> order)
+    {
+        const uint32_t count     = uint32_t(pool.size());
+        int32_t        max_depth = 0;
+
+        // Depth is one more than the deepest object behind, edges closing a cycle are ignored
+        for (uint32_t root = 0; root < count; ++root)
+        {
+            if (pool[root]._depth)
+                continue;
+
+            pool[root]._depth_active = true;
+            _stack.emplace_back(root, pool[root]._back_begin);
+
+            while (!_stack.empty())
+            {
+                const uint32_t node = _stack.back().first;
+                auto&          obj  = pool[node];
+
+                if (_stack.back().second < obj._back_end)
+                {
+                    auto& back = pool[_edges[_stack.back().second++]];
+                    if (back._depth_active)
+                        continue;
+
+                    if (back._depth)
+                    {
+                        obj._depth = std::max<int32_t>(obj._depth, back._depth);
+                        continue;
+                    }
+
+                    back._depth_active = true;
+                    _stack.emplace_back(uint32_t(&back - pool.data()), back._back_begin);
+                    continue;
+                }
+
+                obj._depth        = obj._depth + 1;
+                obj._depth_active = false;
+                max_depth         = std::max<int32_t>(max_depth, obj._depth);
+                _stack.pop_back();
+
+                if (!_stack.empty())
+                {
+                    auto& parent  = pool[_stack.back().first];
+                    parent._depth = std::max<int32_t>(parent._depth, obj._depth);
+                }
+            }
+        }
+
+        // Counting sort by depth, keeps pool order within a level
+        _bin_start.assign(size_t(max_depth) + 2, 0);
+        for (uint32_t n = 0; n < count; ++n)
+            ++_bin_start[pool[n]._depth + 1];
+        for (size_t n = 1; n < _bin_start.size(); ++n)
+            _bin_start[n] += _bin_start[n - 1];
+        for (uint32_t n = 0; n < count; ++n)
+            order[_bin_start[pool[n]._depth]++] = &pool[n];
+    }
+
+} // namespace fin
@@ -2,16 +2,73 @@
 
 #include "api/math_utils.hpp"
 
+#include <cassert>
+#include <limits>
+#include <memory>
 #include <span>
 #include <string>
 #include <vector>
 
 namespace fin
 {
-    template <typename T, typename BoundsGetter, int32_t MAX_OBJECTS = 4, int32_t MAX_LEVELS = 8>
+    /// Vector growing in fixed size chunks, elements never move so references stay valid on growth.
+    template <typename T, int32_t CHUNK_BITS = 10>
+    class ChunkedVector
+    {
+    public:
+        static constexpr size_t ChunkSize = size_t(1) << CHUNK_BITS;
+
+        T& operator[](size_t n)
+        {
+            return _chunks[n >> CHUNK_BITS][n & (ChunkSize - 1)];
+        }
+
+        const T& operator[](size_t n) const
+        {
+            return _chunks[n >> CHUNK_BITS][n & (ChunkSize - 1)];
+        }
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+        T& emplace_back()
+        {
+            if (_size == _chunks.size() * ChunkSize)
+                _chunks.emplace_back(std::make_unique<T[]>(ChunkSize));
+            return (*this)[_size++];
+        }
+
+        void push_back(const T& val)
+        {
+            emplace_back() = val;
+        }
+
+        void reserve(size_t n)
+        {
+            _chunks.reserve((n + ChunkSize - 1) / ChunkSize);
+        }
+
+        void clear()
+        {
+            _chunks.clear();
+            _size = 0;
+        }
+
+    private:
+        std::vector<std::unique_ptr<T[]>> _chunks;
+        size_t                            _size{};
+    };
+
+    /// Loose quadtree over objects stored in a chunked pool. Index is the type of the per object
+    /// links, it bounds the number of objects a tree can hold.
+    template <typename T, typename BoundsGetter, int32_t MAX_OBJECTS = 4, int32_t MAX_LEVELS = 8, typename Index = int32_t>
     class LooseQuadTree
     {
-        using ThisType = LooseQuadTree<T, BoundsGetter, MAX_OBJECTS, MAX_LEVELS>;
+        static_assert(std::is_signed_v<Index>, "Index must be signed, -1 ends a list");
+
+        using ThisType = LooseQuadTree<T, BoundsGetter, MAX_OBJECTS, MAX_LEVELS, Index>;
 
         struct ObjectSlot
         {
@@ -23,7 +80,7 @@ namespace fin
             }
 
             std::aligned_storage_t<sizeof(T), alignof(T)> data;
-            int16_t                                       next  = -1;
+            Index                                         next  = -1;
             bool                                          empty = true;
 
             T* get()
@@ -40,7 +97,7 @@ namespace fin
         {
             Rectf   bounds;
             int32_t children[4] = {-1, -1, -1, -1};
-            int16_t firstObject = -1;
+            Index   firstObject = -1;
             int16_t level       = 0;
             int32_t objectCount = 0;
 
@@ -50,10 +107,10 @@ namespace fin
             }
         };
 
-        std::vector<Node>       nodes;
-        std::vector<int32_t>    outside;
-        std::vector<ObjectSlot> objects;
-        std::vector<int32_t>    active;
+        ChunkedVector<Node>       nodes;
+        std::vector<int32_t>      outside;
+        ChunkedVector<ObjectSlot> objects;
+        std::vector<int32_t>      active;
         int32_t                 rootIndex          = -1;
         int32_t                 nodeFreeListHead   = -1;
         int32_t                 objectFreeListHead = -1;
@@ -74,6 +131,7 @@ namespace fin
         void swap(LooseQuadTree& other)
         {
             std::swap(nodes, other.nodes);
+            std::swap(outside, other.outside);
             std::swap(objects, other.objects);
             std::swap(active, other.active);
             std::swap(rootIndex, other.rootIndex);
@@ -86,6 +144,8 @@ namespace fin
             auto worldBounds = nodes[rootIndex].bounds;
             objects.clear();
             nodes.clear();
+            outside.clear();
+            active.clear();
 
             nodeFreeListHead   = -1;
             objectFreeListHead = -1;
@@ -105,9 +165,7 @@ namespace fin
             {
                 if (objects[i].empty)
                     continue;
-                const T& obj = *objects[i].get();
-                const Rectf objBounds = boundsGetter(obj);
-                newTree.insert(newTree.rootIndex, obj, objBounds);
+                newTree.insert(*objects[i].get());
             }
             swap(newTree);
         }
@@ -218,7 +276,7 @@ namespace fin
 
         const T& operator[](int32_t n) const
         {
-            return objects[n].object;
+            return *objects[n].get();
         }
 
         int32_t size() const
@@ -244,7 +302,7 @@ namespace fin
             {
                 auto& obj = objects[n];
                 if (!obj.empty)
-                    cb(obj.object);
+                    cb(*obj.get());
             }
         }
 
@@ -299,7 +357,7 @@ namespace fin
             }
             else
             {
-                nodes.push_back(Node{bounds, {-1, -1, -1, -1}, -1, level});
+                nodes.emplace_back() = Node{bounds, {-1, -1, -1, -1}, -1, level};
                 return static_cast<int>(nodes.size()) - 1;
             }
         }
@@ -307,7 +365,7 @@ namespace fin
         void freeNode(int idx)
         {
             nodes[idx].firstObject  = -1;
-            nodes[idx].objectsCount = 0;
+            nodes[idx].objectCount  = 0;
             nodes[idx].bounds       = {0, 0, 0, 0};
             nodes[idx].level        = -1;
             nodes[idx].children[0]  = nodeFreeListHead;
@@ -325,6 +383,7 @@ namespace fin
             }
             else
             {
+                assert(objects.size() < size_t(std::numeric_limits<Index>::max()) && "Index type too narrow");
                 idx = static_cast<int32_t>(objects.size());
                 objects.emplace_back();
             }
@@ -546,8 +605,8 @@ namespace fin
             if (!node.bounds.intersects(bounds))
                 return false;
 
-            int16_t* prev    = &node.firstObject;
-            int16_t  current = node.firstObject;
+            Index* prev    = &node.firstObject;
+            Index  current = node.firstObject;
 
             while (current != -1)
             {
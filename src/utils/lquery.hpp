@@ -3,6 +3,7 @@
 #include "api/math_utils.hpp"
 
 #include <memory>
+#include <vector>
 
 namespace fin
 {
@@ -13,16 +14,30 @@ namespace fin
         public:
             struct Proxy
             {
-                Proxy*  _next{};
-                Proxy*  _prev{};
-                Proxy** _bin{};
-                Vec2f   _position;
+                Proxy*   _next{};
+                Proxy*   _prev{};
+                Proxy**  _bin{};
+                Vec2f    _position;
+                Regionf  _bbox;     // world extents, set before update_for_new_location
+                int32_t  _cell{-1}; // grid storage, cell and slot in the cell arrays
+                uint32_t _slot{};
+            };
+
+            enum class Storage
+            {
+                Lists, // intrusive linked lists threaded through the proxies
+                Grid,  // contiguous per cell arrays with positions kept as SoA
             };
 
         public:
+            static constexpr float LargeExtent = 512.f; // objects reaching farther from their position are kept apart
+            static constexpr float LargeCells  = 4.f;   // or farther than this many bins, whichever is more
+
             SpatialDatabase() = default;
 
             void           init(Rectf region, int32_t divx, int32_t divy);
+            void           init_grid(Rectf region, float cell_size);
+            Storage        storage() const;
             void           remove_from_bin(Proxy* object);
             void           update_for_new_location(Proxy* object);
             int            bin_index(float x, float y) const;
@@ -32,15 +47,39 @@ namespace fin
             void map_over_all_objects_in_locality(float x, float y, float radius, CB cb) const;
             template <typename CB>
             void map_over_all_objects_in_locality(const Rectf& rc, CB cb) const;
+            template <typename CB>
+            void map_over_all_objects_in_region(const Rectf& rc, CB cb) const;
+            template <typename CB>
+            void map_over_all_objects_at(Vec2f pt, CB cb) const;
 
         private:
+            struct Cell
+            {
+                std::vector<Proxy*> items;
+                std::vector<float>  xs;
+                std::vector<float>  ys;
+            };
+
             void add_to_bin(Proxy* object, Proxy** bin);
+            bool is_large(const Proxy* object) const;
+            void grow_margin(const Proxy* object);
+            int  cell_for_location(float x, float y) const;
+            void add_to_cell(Proxy* object, int32_t cell);
+            void remove_from_cell(Proxy* object);
+
+            template <typename CB>
+            static void traverse_cell(const Cell& cell, float x, float y, float radiusSquared, CB& cb);
 
             Rectf                            _region;
             int32_t                          _divx{};
             int32_t                          _divy{};
             std::unique_ptr<Proxy*[]> _bins;
             Proxy*                    _other{};
+            Proxy*                    _large{}; // objects reaching past _large_size, tested by bbox on every query
+            Regionf                   _margin;  // largest extents of binned objects around their position
+            float                     _large_size{};
+            std::vector<Cell>         _cells; // grid storage, cells then the outside and large cells
+            Storage                   _storage{Storage::Lists};
         };
 
         inline void SpatialDatabase::init(Rectf region, int32_t divx, int32_t divy)
@@ -51,19 +90,109 @@ namespace fin
             const auto bincount = _divx * _divy;
             _bins               = std::make_unique<Proxy*[]>(bincount);
             _other              = nullptr;
+            _large              = nullptr;
+            _margin             = {};
+            _large_size         = std::max(LargeExtent,
+                                   LargeCells * std::min(_region.width / std::max(_divx, 1), _region.height / std::max(_divy, 1)));
+            _storage            = Storage::Lists;
+            _cells.clear();
+        }
+
+        inline void SpatialDatabase::init_grid(Rectf region, float cell_size)
+        {
+            cell_size = std::max(cell_size, 1.f);
+            _divx     = std::max(1, (int32_t)std::ceil(region.width / cell_size));
+            _divy     = std::max(1, (int32_t)std::ceil(region.height / cell_size));
+            _region   = {region.x, region.y, _divx * cell_size, _divy * cell_size};
+            _bins.reset();
+            _other      = nullptr;
+            _large      = nullptr;
+            _margin     = {};
+            _large_size = std::max(LargeExtent, LargeCells * cell_size);
+            _storage    = Storage::Grid;
+            _cells.clear();
+            _cells.resize(_divx * _divy + 2);
+        }
+
+        inline SpatialDatabase::Storage SpatialDatabase::storage() const
+        {
+            return _storage;
+        }
+
+        inline bool SpatialDatabase::is_large(const Proxy* object) const
+        {
+            /* bounds the query margin, independent of how fine the bins are */
+            const auto& p = object->_position;
+            const auto& b = object->_bbox;
+            return std::max({p.x - b.x1, b.x2 - p.x, p.y - b.y1, b.y2 - p.y}) > _large_size;
+        }
+
+        inline void SpatialDatabase::grow_margin(const Proxy* object)
+        {
+            _margin.x1 = std::max(_margin.x1, object->_position.x - object->_bbox.x1);
+            _margin.y1 = std::max(_margin.y1, object->_position.y - object->_bbox.y1);
+            _margin.x2 = std::max(_margin.x2, object->_bbox.x2 - object->_position.x);
+            _margin.y2 = std::max(_margin.y2, object->_bbox.y2 - object->_position.y);
+        }
+
+        inline int SpatialDatabase::cell_for_location(float x, float y) const
+        {
+            if (!_region.contains(x, y))
+                return _divx * _divy;
+
+            return bin_index(x, y);
+        }
+
+        inline void SpatialDatabase::add_to_cell(Proxy* object, int32_t cell)
+        {
+            auto& c       = _cells[cell];
+            object->_cell = cell;
+            object->_slot = uint32_t(c.items.size());
+            c.items.push_back(object);
+            c.xs.push_back(object->_position.x);
+            c.ys.push_back(object->_position.y);
+        }
+
+        inline void SpatialDatabase::remove_from_cell(Proxy* object)
+        {
+            if (object->_cell < 0 || object->_cell >= (int32_t)_cells.size())
+            {
+                object->_cell = -1;
+                return;
+            }
+
+            /* swap the last entry into the freed slot */
+            auto&      c    = _cells[object->_cell];
+            const auto slot = object->_slot;
+            const auto last = c.items.size() - 1;
+            if (slot != last)
+            {
+                c.items[slot]        = c.items[last];
+                c.xs[slot]           = c.xs[last];
+                c.ys[slot]           = c.ys[last];
+                c.items[slot]->_slot = slot;
+            }
+            c.items.pop_back();
+            c.xs.pop_back();
+            c.ys.pop_back();
+            object->_cell = -1;
         }
 
         inline int SpatialDatabase::bin_index(float x, float y) const
         {
             /* if point inside super-brick, compute the bin coordinates */
-            const auto ix = (int)(((x - _region.x) / _region.width) * _divx);
-            const auto iy = (int)(((y - _region.y) / _region.height) * _divy);
+            /* the region is inclusive, points on the far edge go to the last bin */
+            const auto ix = std::min((int)(((x - _region.x) / _region.width) * _divx), _divx - 1);
+            const auto iy = std::min((int)(((y - _region.y) / _region.height) * _divy), _divy - 1);
             /* convert to linear bin number */
             return ((iy * _divx) + ix);
         }
 
         inline void SpatialDatabase::remove_from_bin(Proxy* object)
         {
+            if (_storage == Storage::Grid)
+                remove_from_cell(object);
+
             if (object->_bin != nullptr)
             {
                 /* If this object is at the head of the list, move the bin
@@ -122,8 +251,26 @@ namespace fin
 
         inline void SpatialDatabase::update_for_new_location(Proxy* object)
         {
+            const bool large = is_large(object);
+            if (!large)
+                grow_margin(object);
+
+            if (_storage == Storage::Grid)
+            {
+                const int cell = large ? _divx * _divy + 1 : cell_for_location(object->_position.x, object->_position.y);
+                if (cell == object->_cell)
+                {
+                    _cells[cell].xs[object->_slot] = object->_position.x;
+                    _cells[cell].ys[object->_slot] = object->_position.y;
+                    return;
+                }
+                remove_from_cell(object);
+                add_to_cell(object, cell);
+                return;
+            }
+
             /* find bin for new location */
-            Proxy** newBin = bin_for_location(object->_position.x, object->_position.y);
+            Proxy** newBin = large ? &_large : bin_for_location(object->_position.x, object->_position.y);
 
             /* has object moved into a new bin? */
             if (newBin != object->_bin)
@@ -151,6 +298,33 @@ namespace fin
             }
         }
 
+        template <typename CB>
+        inline void SpatialDatabase::traverse_cell(const Cell& cell, float x, float y, float radiusSquared, CB& cb)
+        {
+            constexpr size_t Chunk = 16;
+
+            /* distances are computed a chunk at a time in a branch free loop the compiler can vectorize */
+            float        dist[Chunk];
+            const size_t count = cell.items.size();
+            for (size_t base = 0; base < count; base += Chunk)
+            {
+                const size_t n  = std::min(Chunk, count - base);
+                const float* xs = cell.xs.data() + base;
+                const float* ys = cell.ys.data() + base;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const float dx = x - xs[i];
+                    const float dy = y - ys[i];
+                    dist[i]        = dx * dx + dy * dy;
+                }
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (dist[i] < radiusSquared)
+                        cb(cell.items[base + i], dist[i]);
+                }
+            }
+        }
+
         template <typename CB>
         inline void SpatialDatabase::map_over_all_objects_in_locality(float x, float y, float radius, CB cb) const
         {
@@ -158,10 +332,19 @@ namespace fin
                                             ((x - radius) >= _region.x2()) || ((y - radius) >= _region.y2()));
             const auto radiusSqrt        = radius * radius;
 
+            /* large objects are kept apart from the bins */
+            if (_storage == Storage::Grid)
+                traverse_cell(_cells[_divx * _divy + 1], x, y, radiusSqrt, cb);
+            else
+                traverse_bin_client_object_list<CB>(_large, x, y, radiusSqrt, cb);
+
             /* is the sphere completely outside the "super brick"? */
             if (completelyOutside)
             {
-                traverse_bin_client_object_list<CB>(_other, x, y, radiusSqrt, cb);
+                if (_storage == Storage::Grid)
+                    traverse_cell(_cells[_divx * _divy], x, y, radiusSqrt, cb);
+                else
+                    traverse_bin_client_object_list<CB>(_other, x, y, radiusSqrt, cb);
                 return;
             }
 
@@ -194,6 +377,20 @@ namespace fin
                 maxBinY   = _divy - 1;
             }
 
+            if (_storage == Storage::Grid)
+            {
+                if (partlyOut)
+                    traverse_cell(_cells[_divx * _divy], x, y, radiusSqrt, cb);
+
+                for (int ny = minBinY; ny <= maxBinY; ++ny)
+                {
+                    const int line = ny * _divx;
+                    for (int nx = minBinX; nx <= maxBinX; ++nx)
+                        traverse_cell(_cells[nx + line], x, y, radiusSqrt, cb);
+                }
+                return;
+            }
+
             /* map function over outside objects if necessary (if clipped) */
             if (partlyOut)
                 traverse_bin_client_object_list<CB>(_other, x, y, radiusSqrt, cb);
@@ -225,10 +422,29 @@ namespace fin
         template <typename CB>
         inline void SpatialDatabase::map_over_all_objects_in_locality(const Rectf& rc, CB cb) const
         {
+            auto traverse_rect = [&](const Cell& cell)
+            {
+                const size_t count = cell.items.size();
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (cell.xs[i] >= rc.x && cell.xs[i] <= rc.x2() && cell.ys[i] >= rc.y && cell.ys[i] <= rc.y2())
+                        cb(cell.items[i]);
+                }
+            };
+
+            /* large objects are kept apart from the bins */
+            if (_storage == Storage::Grid)
+                traverse_rect(_cells[_divx * _divy + 1]);
+            else
+                traverse_bin_client_object_list<CB>(_large, rc, cb);
+
             /* is the sphere completely outside the "super brick"? */
             if (!_region.intersects(rc))
             {
-                traverse_bin_client_object_list<CB>(_other, rc, cb);
+                if (_storage == Storage::Grid)
+                    traverse_rect(_cells[_divx * _divy]);
+                else
+                    traverse_bin_client_object_list<CB>(_other, rc, cb);
                 return;
             }
 
@@ -262,6 +478,20 @@ namespace fin
                 maxBinY   = _divy - 1;
             }
 
+            if (_storage == Storage::Grid)
+            {
+                if (partlyOut)
+                    traverse_rect(_cells[_divx * _divy]);
+
+                for (int ny = minBinY; ny <= maxBinY; ++ny)
+                {
+                    const int line = ny * _divx;
+                    for (int nx = minBinX; nx <= maxBinX; ++nx)
+                        traverse_rect(_cells[nx + line]);
+                }
+                return;
+            }
+
             /* map function over outside objects if necessary (if clipped) */
             if (partlyOut)
                 traverse_bin_client_object_list<CB>(_other, rc, cb);
@@ -277,5 +507,47 @@ namespace fin
                 }
             }
         }
+
+        template <typename CB>
+        inline void SpatialDatabase::map_over_all_objects_in_region(const Rectf& rc, CB cb) const
+        {
+            const Regionf area(rc.x, rc.y, rc.x2(), rc.y2());
+
+            /* large objects are tested on their own, binned ones are found by position within the margin */
+            auto test = [&](Proxy* co)
+            {
+                if (co->_bbox.intersects(area))
+                    cb(co);
+            };
+
+            if (_storage == Storage::Grid)
+            {
+                for (auto* co : _cells[_divx * _divy + 1].items)
+                    test(co);
+            }
+            else
+            {
+                for (auto* co = _large; co != nullptr; co = co->_next)
+                    test(co);
+            }
+
+            const Rectf wide(rc.x - _margin.x2,
+                             rc.y - _margin.y2,
+                             rc.width + _margin.x1 + _margin.x2,
+                             rc.height + _margin.y1 + _margin.y2);
+
+            auto binned = [&](Proxy* co)
+            {
+                if (co->_bin != &_large && co->_cell != _divx * _divy + 1)
+                    test(co);
+            };
+            map_over_all_objects_in_locality(wide, binned);
+        }
+
+        template <typename CB>
+        inline void SpatialDatabase::map_over_all_objects_at(Vec2f pt, CB cb) const
+        {
+            map_over_all_objects_in_region(Rectf(pt.x, pt.y, 0, 0), cb);
+        }
     }; // namespace lq
 };     // namespace box
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "api/math_utils.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace fin
+{
+    /// Vertex layout shared with the GPU buffers, position, uv and rgba color.
+    struct GeometryVertex
+    {
+        float   x, y;
+        float   u, v;
+        uint8_t r, g, b, a;
+    };
+
+    /// Consecutive indices drawn with one texture.
+    struct GeometryBatch
+    {
+        uint32_t texture;
+        uint32_t first; // offset in GeometryChunk::indices
+        uint32_t count;
+    };
+
+    struct GeometryChunk
+    {
+        Regionf                     bounds{FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+        std::vector<GeometryVertex> vertices;
+        std::vector<uint16_t>       indices;
+        std::vector<GeometryBatch>  batches;
+    };
+
+    /// Geometry of static layers baked once into vertex and index arrays.
+    /// Shapes are added in draw order and cut into consecutive chunks of a bounded vertex count, so
+    /// drawing the chunks in order keeps the order of the layer exactly. A chunk merges consecutive
+    /// shapes using the same texture into one batch and is culled by the bounds of its shapes, which
+    /// stay tight as long as the draw order is roughly spatial, as rows sorted by y are.
+    /// Nothing here touches the GPU, Renderer::render_geometry uploads and draws the result.
+    class StaticGeometry
+    {
+    public:
+        static constexpr uint32_t MaxVertices = 0xffff; // indices are 16 bit
+
+        /// Starts a new bake, chunk_vertices bounds the size of a chunk and so the culling granularity.
+        void begin(uint32_t chunk_vertices = MaxVertices);
+        void end();
+        void clear();
+
+        void add_quad(uint32_t texture, const Regionf& dest, const Regionf& uv, const uint8_t (&color)[4]);
+        void add_triangles(uint32_t texture, std::span<const Vec2f> points, Vec2f uv_origin, Vec2f uv_scale, const uint8_t (&color)[4]);
+
+        std::span<const GeometryChunk> chunks() const;
+        /// Chunks intersecting view, in draw order.
+        void     query(const Rectf& view, std::vector<const GeometryChunk*>& out) const;
+        uint32_t revision() const;
+        bool     empty() const;
+
+    private:
+        GeometryChunk& reserve(const Regionf& bounds, uint32_t texture, uint32_t vertices, uint32_t indices);
+
+        std::vector<GeometryChunk> _chunks;
+        uint32_t                   _chunk_vertices{MaxVertices};
+        uint32_t                   _revision{};
+    };
+
+    inline void StaticGeometry::begin(uint32_t chunk_vertices)
+    {
+        _chunks.clear();
+        _chunk_vertices = std::clamp<uint32_t>(chunk_vertices, 12, MaxVertices);
+    }
+
+    inline void StaticGeometry::end()
+    {
+        ++_revision;
+    }
+
+    inline void StaticGeometry::clear()
+    {
+        begin(_chunk_vertices);
+        ++_revision;
+    }
+
+    inline GeometryChunk& StaticGeometry::reserve(const Regionf& bounds, uint32_t texture, uint32_t vertices, uint32_t indices)
+    {
+        // Only the last chunk is open, shapes never move ahead of earlier ones
+        if (_chunks.empty() || _chunks.back().vertices.size() + vertices > _chunk_vertices)
+            _chunks.emplace_back();
+
+        auto& chunk = _chunks.back();
+        chunk.bounds.x1 = std::min(chunk.bounds.x1, bounds.x1);
+        chunk.bounds.y1 = std::min(chunk.bounds.y1, bounds.y1);
+        chunk.bounds.x2 = std::max(chunk.bounds.x2, bounds.x2);
+        chunk.bounds.y2 = std::max(chunk.bounds.y2, bounds.y2);
+
+        if (chunk.batches.empty() || chunk.batches.back().texture != texture)
+            chunk.batches.push_back({texture, uint32_t(chunk.indices.size()), 0});
+        chunk.batches.back().count += indices;
+        return chunk;
+    }
+
+    inline void StaticGeometry::add_quad(uint32_t texture, const Regionf& dest, const Regionf& uv, const uint8_t (&color)[4])
+    {
+        auto&          chunk = reserve(dest, texture, 4, 6);
+        const uint16_t base  = uint16_t(chunk.vertices.size());
+        const auto [r, g, b, a] = color;
+
+        chunk.vertices.push_back({dest.x1, dest.y1, uv.x1, uv.y1, r, g, b, a});
+        chunk.vertices.push_back({dest.x1, dest.y2, uv.x1, uv.y2, r, g, b, a});
+        chunk.vertices.push_back({dest.x2, dest.y2, uv.x2, uv.y2, r, g, b, a});
+        chunk.vertices.push_back({dest.x2, dest.y1, uv.x2, uv.y1, r, g, b, a});
+
+        for (uint16_t i : {0, 1, 2, 0, 2, 3})
+            chunk.indices.push_back(base + i);
+    }
+
+    inline void StaticGeometry::add_triangles(uint32_t texture,
+                                              std::span<const Vec2f> points,
+                                              Vec2f uv_origin,
+                                              Vec2f uv_scale,
+                                              const uint8_t (&color)[4])
+    {
+        if (points.size() < 3)
+            return;
+
+        Regionf bounds(points[0], points[0]);
+        for (auto& pt : points)
+        {
+            bounds.x1 = std::min(bounds.x1, pt.x);
+            bounds.y1 = std::min(bounds.y1, pt.y);
+            bounds.x2 = std::max(bounds.x2, pt.x);
+            bounds.y2 = std::max(bounds.y2, pt.y);
+        }
+
+        const auto [r, g, b, a] = color;
+        const uint32_t count    = uint32_t(points.size() / 3) * 3;
+        for (uint32_t first = 0; first < count;)
+        {
+            // Large shapes continue in the next chunk once the chunk is full
+            const uint32_t part  = std::min(count - first, _chunk_vertices / 3 * 3);
+            auto&          chunk = reserve(bounds, texture, part, part);
+            const uint16_t base  = uint16_t(chunk.vertices.size());
+            for (uint32_t i = 0; i < part; ++i)
+            {
+                const Vec2f pt = points[first + i];
+                chunk.vertices.push_back(
+                    {pt.x, pt.y, (pt.x - uv_origin.x) * uv_scale.x, (pt.y - uv_origin.y) * uv_scale.y, r, g, b, a});
+                chunk.indices.push_back(uint16_t(base + i));
+            }
+            first += part;
+        }
+    }
+
+    inline std::span<const GeometryChunk> StaticGeometry::chunks() const
+    {
+        return _chunks;
+    }
+
+    inline void StaticGeometry::query(const Rectf& view, std::vector<const GeometryChunk*>& out) const
+    {
+        out.clear();
+        for (auto& chunk : _chunks)
+        {
+            if (chunk.bounds.intersects(view))
+                out.push_back(&chunk);
+        }
+    }
+
+    inline uint32_t StaticGeometry::revision() const
+    {
+        return _revision;
+    }
+
+    inline bool StaticGeometry::empty() const
+    {
+        return _chunks.empty();
+    }
+
+} // namespace fin
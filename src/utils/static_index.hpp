@@ -0,0 +1,272 @@
+#pragma once
+
+#include "api/math_utils.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace fin
+{
+    /// Immutable spatial index bulk loaded from a list of boxes.
+    /// Objects are binned by center in square tiles; each tile keeps its objects sorted by draw key
+    /// with a flat bounding volume hierarchy over consecutive runs of them. A query walks the
+    /// hierarchies in order, so every tile yields an already sorted run and the result only needs
+    /// a merge of the few runs in view instead of a sort.
+    class StaticIndex
+    {
+    public:
+        static constexpr uint32_t LeafSize = 8; // objects per leaf box
+        static constexpr uint32_t Branch   = 4; // child boxes per inner box
+
+        struct Item
+        {
+            Rectf    bbox;
+            uint64_t key; // draw order, lower first
+            int32_t  id;
+        };
+
+        /// Key ordering floats the same way as their values.
+        static uint32_t float_key(float v)
+        {
+            const uint32_t u = std::bit_cast<uint32_t>(v);
+            return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+        }
+
+        void build(std::vector<Item>& items, float tile_size);
+        void clear();
+        bool empty() const;
+
+        /// Ids of objects intersecting area, sorted by key.
+        void query(const Rectf& area, std::vector<int32_t>& out) const;
+
+    private:
+        struct Tile
+        {
+            uint32_t begin{}; // range in _items
+            uint32_t end{};
+            uint32_t level{}; // first entry in _levels, from leaves up
+            uint32_t depth{};
+            Regionf  bounds;
+        };
+
+        struct Level
+        {
+            uint32_t offset; // first box in _boxes
+            uint32_t count;
+        };
+
+        void traverse(const Tile& tile, uint32_t lvl, uint32_t box, const Regionf& area, std::vector<uint32_t>& out) const;
+
+        std::vector<Item>     _items;
+        std::vector<Tile>     _tiles;
+        std::vector<Level>    _levels;
+        std::vector<Regionf>  _boxes;
+        Regionf               _bounds;
+        Vec2f                 _reach; // largest half extent, centers lie this far from any hit
+        float                 _inv_size{};
+        int32_t               _cols{};
+        int32_t               _rows{};
+
+        mutable std::vector<uint32_t>                     _hits; // scratch, positions in _items
+        mutable std::vector<uint32_t>                     _merged;
+        mutable std::vector<std::pair<uint32_t, uint32_t>> _runs; // (next, end) in _hits
+    };
+
+    inline void StaticIndex::clear()
+    {
+        _items.clear();
+        _tiles.clear();
+        _levels.clear();
+        _boxes.clear();
+        _cols = _rows = 0;
+    }
+
+    inline bool StaticIndex::empty() const
+    {
+        return _items.empty();
+    }
+
+    inline void StaticIndex::build(std::vector<Item>& items, float tile_size)
+    {
+        clear();
+        if (items.empty())
+            return;
+
+        // Grid over object centers
+        Regionf bounds(items[0].bbox);
+        _reach = {};
+        for (auto& it : items)
+        {
+            const Vec2f c(it.bbox.x + it.bbox.width * 0.5f, it.bbox.y + it.bbox.height * 0.5f);
+            bounds.x1 = std::min(bounds.x1, c.x);
+            bounds.y1 = std::min(bounds.y1, c.y);
+            bounds.x2 = std::max(bounds.x2, c.x);
+            bounds.y2 = std::max(bounds.y2, c.y);
+            _reach.x  = std::max(_reach.x, it.bbox.width * 0.5f);
+            _reach.y  = std::max(_reach.y, it.bbox.height * 0.5f);
+        }
+
+        _bounds   = bounds;
+        _inv_size = 1.f / std::max(tile_size, 1.f);
+        _cols     = int32_t((bounds.x2 - bounds.x1) * _inv_size) + 1;
+        _rows     = int32_t((bounds.y2 - bounds.y1) * _inv_size) + 1;
+
+        auto tile_of = [&](const Item& it)
+        {
+            const int32_t c = std::min(int32_t((it.bbox.x + it.bbox.width * 0.5f - bounds.x1) * _inv_size), _cols - 1);
+            const int32_t r = std::min(int32_t((it.bbox.y + it.bbox.height * 0.5f - bounds.y1) * _inv_size), _rows - 1);
+            return uint32_t(r * _cols + c);
+        };
+
+        // Tile major, draw order within a tile
+        std::sort(items.begin(),
+                  items.end(),
+                  [&](const Item& a, const Item& b)
+                  {
+                      const uint32_t ta = tile_of(a);
+                      const uint32_t tb = tile_of(b);
+                      return ta < tb || (ta == tb && a.key < b.key);
+                  });
+        _items.swap(items);
+
+        _tiles.resize(size_t(_cols) * _rows);
+        for (uint32_t n = 0; n < _items.size();)
+        {
+            auto&          tile = _tiles[tile_of(_items[n])];
+            const uint32_t id   = tile_of(_items[n]);
+            tile.begin          = n;
+            while (n < _items.size() && tile_of(_items[n]) == id)
+                ++n;
+            tile.end = n;
+
+            // Leaf boxes over consecutive objects, then inner boxes over consecutive children
+            tile.level = uint32_t(_levels.size());
+            uint32_t count = (tile.end - tile.begin + LeafSize - 1) / LeafSize;
+            _levels.push_back({uint32_t(_boxes.size()), count});
+            for (uint32_t b = 0; b < count; ++b)
+            {
+                const uint32_t first = tile.begin + b * LeafSize;
+                const uint32_t last  = std::min(first + LeafSize, tile.end);
+                Regionf        box(_items[first].bbox);
+                for (uint32_t i = first + 1; i < last; ++i)
+                {
+                    const Regionf bb(_items[i].bbox);
+                    box.x1 = std::min(box.x1, bb.x1);
+                    box.y1 = std::min(box.y1, bb.y1);
+                    box.x2 = std::max(box.x2, bb.x2);
+                    box.y2 = std::max(box.y2, bb.y2);
+                }
+                _boxes.push_back(box);
+            }
+
+            while (count > 1)
+            {
+                const Level below = _levels.back();
+                count             = (below.count + Branch - 1) / Branch;
+                _levels.push_back({uint32_t(_boxes.size()), count});
+                for (uint32_t b = 0; b < count; ++b)
+                {
+                    const uint32_t first = below.offset + b * Branch;
+                    const uint32_t last  = std::min(first + Branch, below.offset + below.count);
+                    Regionf        box   = _boxes[first];
+                    for (uint32_t i = first + 1; i < last; ++i)
+                    {
+                        box.x1 = std::min(box.x1, _boxes[i].x1);
+                        box.y1 = std::min(box.y1, _boxes[i].y1);
+                        box.x2 = std::max(box.x2, _boxes[i].x2);
+                        box.y2 = std::max(box.y2, _boxes[i].y2);
+                    }
+                    _boxes.push_back(box);
+                }
+            }
+
+            tile.depth  = uint32_t(_levels.size()) - tile.level;
+            tile.bounds = _boxes[_levels.back().offset];
+        }
+    }
+
+    inline void StaticIndex::traverse(const Tile& tile, uint32_t lvl, uint32_t box, const Regionf& area, std::vector<uint32_t>& out) const
+    {
+        const Level& level = _levels[tile.level + lvl];
+        if (!_boxes[level.offset + box].intersects(area))
+            return;
+
+        if (lvl == 0)
+        {
+            const uint32_t first = tile.begin + box * LeafSize;
+            const uint32_t last  = std::min(first + LeafSize, tile.end);
+            for (uint32_t i = first; i < last; ++i)
+            {
+                if (area.intersects(_items[i].bbox))
+                    out.push_back(i);
+            }
+            return;
+        }
+
+        const uint32_t children = _levels[tile.level + lvl - 1].count;
+        for (uint32_t c = box * Branch, e = std::min(c + Branch, children); c < e; ++c)
+            traverse(tile, lvl - 1, c, area, out);
+    }
+
+    inline void StaticIndex::query(const Rectf& area, std::vector<int32_t>& out) const
+    {
+        out.clear();
+        if (_items.empty())
+            return;
+
+        const Regionf rc(area);
+        auto          col = [&](float x) { return std::clamp(int32_t((x - _bounds.x1) * _inv_size), 0, _cols - 1); };
+        auto          row = [&](float y) { return std::clamp(int32_t((y - _bounds.y1) * _inv_size), 0, _rows - 1); };
+
+        if (rc.x2 + _reach.x < _bounds.x1 || rc.x1 - _reach.x > _bounds.x2 || rc.y2 + _reach.y < _bounds.y1 ||
+            rc.y1 - _reach.y > _bounds.y2)
+            return;
+
+        // Every tile gives one sorted run
+        _hits.clear();
+        _runs.clear();
+        for (int32_t r = row(rc.y1 - _reach.y), r2 = row(rc.y2 + _reach.y); r <= r2; ++r)
+        {
+            for (int32_t c = col(rc.x1 - _reach.x), c2 = col(rc.x2 + _reach.x); c <= c2; ++c)
+            {
+                const Tile& tile = _tiles[r * _cols + c];
+                if (tile.begin == tile.end || !tile.bounds.intersects(rc))
+                    continue;
+
+                const uint32_t begin = uint32_t(_hits.size());
+                traverse(tile, tile.depth - 1, 0, rc, _hits);
+                if (_hits.size() != begin)
+                    _runs.emplace_back(begin, uint32_t(_hits.size()));
+            }
+        }
+
+        const std::vector<uint32_t>* sorted = &_hits;
+        if (_runs.size() > 1)
+        {
+            // Merge the runs, there are only as many as tiles in view
+            auto later = [&](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b)
+            { return _items[_hits[a.first]].key > _items[_hits[b.first]].key; };
+
+            _merged.clear();
+            std::make_heap(_runs.begin(), _runs.end(), later);
+            while (!_runs.empty())
+            {
+                std::pop_heap(_runs.begin(), _runs.end(), later);
+                auto& run = _runs.back();
+                _merged.push_back(_hits[run.first++]);
+                if (run.first == run.second)
+                    _runs.pop_back();
+                else
+                    std::push_heap(_runs.begin(), _runs.end(), later);
+            }
+            sorted = &_merged;
+        }
+
+        out.reserve(sorted->size());
+        for (auto i : *sorted)
+            out.push_back(_items[i].id);
+    }
+
+} // namespace fin
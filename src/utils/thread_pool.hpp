@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fin
+{
+    /// @brief Fixed set of worker threads shared by the engine.
+    /// Jobs are grouped so the caller can wait for a batch; a waiting thread
+    /// executes queued jobs itself, which keeps nested batches deadlock free.
+    class ThreadPool
+    {
+    public:
+        struct Group
+        {
+            std::atomic<int32_t> pending{0};
+        };
+
+        explicit ThreadPool(uint32_t workers);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&)            = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        static ThreadPool& Get();
+
+        uint32_t concurrency() const;
+        void     submit(Group& grp, std::function<void()> job);
+        void     wait(Group& grp);
+
+        template <typename CB>
+        void parallel_for(int32_t count, int32_t grain, CB cb);
+
+    private:
+        bool run_one();
+        void worker();
+
+        struct Job
+        {
+            Group*                grp;
+            std::function<void()> fn;
+        };
+
+        std::vector<std::thread> _threads;
+        std::deque<Job>          _jobs;
+        std::mutex               _mutex;
+        std::condition_variable  _wake;
+        std::condition_variable  _done;
+        bool                     _quit{};
+    };
+
+    inline ThreadPool::ThreadPool(uint32_t workers)
+    {
+        _threads.reserve(workers);
+        for (uint32_t n = 0; n < workers; ++n)
+            _threads.emplace_back([this]() { worker(); });
+    }
+
+    inline ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _quit = true;
+        }
+        _wake.notify_all();
+        for (auto& th : _threads)
+            th.join();
+    }
+
+    inline ThreadPool& ThreadPool::Get()
+    {
+#if defined(__EMSCRIPTEN__)
+        static ThreadPool pool(0);
+#else
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+#endif
+        return pool;
+    }
+
+    inline uint32_t ThreadPool::concurrency() const
+    {
+        return uint32_t(_threads.size()) + 1;
+    }
+
+    inline void ThreadPool::submit(Group& grp, std::function<void()> job)
+    {
+        if (_threads.empty())
+        {
+            job();
+            return;
+        }
+
+        grp.pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(_mutex);
+            _jobs.push_back({&grp, std::move(job)});
+            _done.notify_all(); // threads blocked in wait() help with queued jobs
+        }
+        _wake.notify_one();
+    }
+
+    inline void ThreadPool::wait(Group& grp)
+    {
+        while (grp.pending.load(std::memory_order_acquire) > 0)
+        {
+            if (run_one())
+                continue;
+
+            std::unique_lock lock(_mutex);
+            _done.wait(lock, [&]() { return grp.pending.load(std::memory_order_acquire) <= 0 || !_jobs.empty(); });
+        }
+    }
+
+    inline bool ThreadPool::run_one()
+    {
+        Job job;
+        {
+            std::lock_guard lock(_mutex);
+            if (_jobs.empty())
+                return false;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        job.fn();
+
+        if (job.grp->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard lock(_mutex);
+            _done.notify_all();
+        }
+        return true;
+    }
+
+    inline void ThreadPool::worker()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this]() { return _quit || !_jobs.empty(); });
+                if (_quit)
+                    return;
+            }
+            run_one();
+        }
+    }
+
+    /// Calls cb(begin, end) over [0, count) split in chunks of grain items.
+    /// The calling thread takes part and returns once all chunks are done.
+    template <typename CB>
+    inline void ThreadPool::parallel_for(int32_t count, int32_t grain, CB cb)
+    {
+        if (count <= 0)
+            return;
+
+        grain               = std::max(grain, 1);
+        const int32_t parts = (count + grain - 1) / grain;
+        if (parts == 1 || _threads.empty())
+        {
+            cb(int32_t(0), count);
+            return;
+        }
+
+        std::atomic<int32_t> next{0};
+        auto                 run = [&]()
+        {
+            for (int32_t n = next.fetch_add(1); n < parts; n = next.fetch_add(1))
+                cb(n * grain, std::min(count, (n + 1) * grain));
+        };
+
+        Group         grp;
+        const int32_t helpers = std::min<int32_t>(parts - 1, int32_t(_threads.size()));
+        for (int32_t n = 0; n < helpers; ++n)
+            submit(grp, run);
+
+        run();
+        wait(grp);
+    }
+
+} // namespace fin
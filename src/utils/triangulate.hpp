@@ -0,0 +1,180 @@
+#pragma once
+
+#include "api/math_utils.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace fin
+{
+    /// Ear clipping over a linked ring of vertices.
+    /// Only reflex vertices can lie inside an ear, they are kept in a uniform grid so an ear test looks
+    /// at the few reflex vertices under the triangle instead of the whole polygon. Clipping an ear only
+    /// changes its two neighbours, which are rechecked in place; the whole pass is close to linear for
+    /// the polygons drawn in the editor.
+    class Triangulator
+    {
+    public:
+        /// Appends triangles of a simple polygon as point triplets, stops early on self intersecting input.
+        void run(std::span<const Vec2f> polygon, std::vector<Vec2f>& out);
+
+    private:
+        struct Vertex
+        {
+            Vec2f    pos;
+            uint32_t prev;
+            uint32_t next;
+            bool     reflex;
+        };
+
+        static float cross(const Vec2f& a, const Vec2f& b, const Vec2f& c)
+        {
+            return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        }
+
+        bool     is_ear(uint32_t i) const;
+        uint32_t cell_of(float v, float origin) const;
+
+        std::vector<Vertex>                _ring;
+        std::vector<std::vector<uint32_t>> _cells; // reflex vertices, cleared lazily
+        Regionf                            _bounds;
+        float                              _inv_cell{};
+        uint32_t                           _cols{};
+        uint32_t                           _rows{};
+    };
+
+    inline uint32_t Triangulator::cell_of(float v, float origin) const
+    {
+        return uint32_t(std::max(0.f, (v - origin) * _inv_cell));
+    }
+
+    inline bool Triangulator::is_ear(uint32_t i) const
+    {
+        const auto& b = _ring[i];
+        const auto& a = _ring[b.prev];
+        const auto& c = _ring[b.next];
+        if (b.reflex)
+            return false;
+
+        const uint32_t x1 = std::min(cell_of(std::min({a.pos.x, b.pos.x, c.pos.x}), _bounds.x1), _cols - 1);
+        const uint32_t y1 = std::min(cell_of(std::min({a.pos.y, b.pos.y, c.pos.y}), _bounds.y1), _rows - 1);
+        const uint32_t x2 = std::min(cell_of(std::max({a.pos.x, b.pos.x, c.pos.x}), _bounds.x1), _cols - 1);
+        const uint32_t y2 = std::min(cell_of(std::max({a.pos.y, b.pos.y, c.pos.y}), _bounds.y1), _rows - 1);
+
+        for (uint32_t y = y1; y <= y2; ++y)
+        {
+            for (uint32_t x = x1; x <= x2; ++x)
+            {
+                for (auto n : _cells[y * _cols + x])
+                {
+                    const auto& pt = _ring[n];
+                    if (!pt.reflex || n == b.prev || n == b.next)
+                        continue;
+                    // Points sharing a position with the ear, as in touching outlines, do not block it
+                    if (pt.pos == a.pos || pt.pos == b.pos || pt.pos == c.pos)
+                        continue;
+                    if (cross(b.pos, a.pos, pt.pos) <= 0 && cross(c.pos, b.pos, pt.pos) <= 0 && cross(a.pos, c.pos, pt.pos) <= 0)
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    inline void Triangulator::run(std::span<const Vec2f> polygon, std::vector<Vec2f>& out)
+    {
+        const uint32_t size = uint32_t(polygon.size());
+        if (size < 3)
+            return;
+
+        float area = 0;
+        for (uint32_t i = 0, j = size - 1; i < size; j = i++)
+            area += polygon[j].x * polygon[i].y - polygon[i].x * polygon[j].y;
+
+        // Ring in positive winding
+        _ring.resize(size);
+        _bounds = Regionf(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            auto& v = _ring[i];
+            v.pos   = polygon[area < 0 ? size - 1 - i : i];
+            v.prev  = (i + size - 1) % size;
+            v.next  = (i + 1) % size;
+            _bounds.x1 = std::min(_bounds.x1, v.pos.x);
+            _bounds.y1 = std::min(_bounds.y1, v.pos.y);
+            _bounds.x2 = std::max(_bounds.x2, v.pos.x);
+            _bounds.y2 = std::max(_bounds.y2, v.pos.y);
+        }
+
+        uint32_t reflex = 0;
+        for (auto& v : _ring)
+        {
+            v.reflex = cross(_ring[v.prev].pos, v.pos, _ring[v.next].pos) < 0;
+            reflex += v.reflex;
+        }
+
+        // Grid with about one reflex vertex per cell
+        const float extent = std::max({_bounds.x2 - _bounds.x1, _bounds.y2 - _bounds.y1, FLT_EPSILON});
+        const float cells  = std::clamp(std::sqrt(float(reflex)), 1.f, 256.f);
+        _inv_cell          = cells / extent;
+        _cols              = std::min(cell_of(_bounds.x2, _bounds.x1), 255u) + 1;
+        _rows              = std::min(cell_of(_bounds.y2, _bounds.y1), 255u) + 1;
+        _cells.resize(std::max<size_t>(_cells.size(), size_t(_cols) * _rows));
+        for (auto& cell : _cells)
+            cell.clear();
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            if (_ring[i].reflex)
+            {
+                const uint32_t x = std::min(cell_of(_ring[i].pos.x, _bounds.x1), _cols - 1);
+                const uint32_t y = std::min(cell_of(_ring[i].pos.y, _bounds.y1), _rows - 1);
+                _cells[y * _cols + x].push_back(i);
+            }
+        }
+
+        out.reserve(out.size() + (size - 2) * 3);
+        uint32_t left  = size;
+        uint32_t cur   = 0;
+        uint32_t tries = 0;
+        while (left > 3)
+        {
+            if (tries++ == left)
+                return; // no ear left, the outline crosses itself
+
+            if (!is_ear(cur))
+            {
+                cur = _ring[cur].next;
+                continue;
+            }
+
+            const uint32_t prev = _ring[cur].prev;
+            const uint32_t next = _ring[cur].next;
+            out.push_back(_ring[prev].pos);
+            out.push_back(_ring[cur].pos);
+            out.push_back(_ring[next].pos);
+
+            _ring[prev].next = next;
+            _ring[next].prev = prev;
+            --left;
+            tries = 0;
+
+            // Neighbours may turn convex, a simple polygon never gains reflex vertices
+            for (auto n : {prev, next})
+            {
+                auto& v = _ring[n];
+                if (v.reflex)
+                    v.reflex = cross(_ring[v.prev].pos, v.pos, _ring[v.next].pos) < 0;
+            }
+            cur = prev;
+        }
+
+        out.push_back(_ring[_ring[cur].prev].pos);
+        out.push_back(_ring[cur].pos);
+        out.push_back(_ring[_ring[cur].next].pos);
+    }
+
+} // namespace fin
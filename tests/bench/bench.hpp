@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Minimal benchmark registry for finite_bench, each file registers its cases with FINITE_BENCH.
+namespace bench
+{
+    struct Case
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    inline std::vector<Case>& Cases()
+    {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    struct Register
+    {
+        Register(const char* name, void (*run)())
+        {
+            Cases().push_back({name, run});
+        }
+    };
+
+    /// Milliseconds per call of fn, the best of a few rounds after one warm up call.
+    template <typename F>
+    double Measure(int rounds, F&& fn)
+    {
+        fn();
+        double best = 1e30;
+        for (int n = 0; n < rounds; ++n)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    inline void Report(const char* what, int count, double ms)
+    {
+        std::printf("  %-28s %8d %10.3f ms\n", what, count, ms);
+    }
+} // namespace bench
+
+#define FINITE_BENCH_CAT2(a, b) a##b
+#define FINITE_BENCH_CAT(a, b)  FINITE_BENCH_CAT2(a, b)
+#define FINITE_BENCH(name, fn)  static bench::Register FINITE_BENCH_CAT(s_bench_, __LINE__)(name, fn)
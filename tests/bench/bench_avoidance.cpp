@@ -0,0 +1,139 @@
+// ORCA local avoidance for crowds of agents, neighbours gathered from a grid SpatialDatabase and
+// solved in parallel on the thread pool the way Navigation::update_objects does it.
+#include "bench.hpp"
+
+#include "core/avoidance.hpp"
+#include "utils/lquery.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <cmath>
+
+using namespace fin;
+
+namespace
+{
+    struct Agent : lq::SpatialDatabase::Proxy
+    {
+        Vec2f velocity;
+        Vec2f goal;
+        float radius{8};
+    };
+
+    struct Crowd
+    {
+        std::vector<Agent>  agents;
+        std::vector<Vec2f>  solved;
+        lq::SpatialDatabase spatial;
+        float               time_horizon{1.f};
+    };
+
+    void Setup(Crowd& crowd, int32_t count)
+    {
+        // Agents on a square grid walking to the mirrored position, they all cross in the middle
+        const int32_t side  = int32_t(std::ceil(std::sqrt(float(count))));
+        const float   space = 24.f;
+        const float   world = side * space * 2;
+
+        crowd.spatial.init_grid({-world, -world, world * 2, world * 2}, 64.f);
+        crowd.agents.resize(count);
+        crowd.solved.resize(count);
+        for (int32_t n = 0; n < count; ++n)
+        {
+            auto& a     = crowd.agents[n];
+            a._position = Vec2f((n % side - side * 0.5f) * space, (n / side - side * 0.5f) * space);
+            a._bbox     = Regionf(a._position.x - a.radius, a._position.y - a.radius, a._position.x + a.radius, a._position.y + a.radius);
+            a.goal      = -a._position;
+            crowd.spatial.update_for_new_location(&a);
+        }
+    }
+
+    void Step(Crowd& crowd, float dt)
+    {
+        constexpr float MaxSpeed = 60.f;
+
+        ThreadPool::Get().parallel_for(
+            int32_t(crowd.agents.size()),
+            64,
+            [&](int32_t begin, int32_t end)
+            {
+                AvoidanceAgent neighbors[Avoidance::MaxNeighbors];
+                float          distance[Avoidance::MaxNeighbors];
+                for (int32_t n = begin; n < end; ++n)
+                {
+                    const Agent& self  = crowd.agents[n];
+                    const float  range = MaxSpeed * crowd.time_horizon + self.radius * 2;
+
+                    // Nearest neighbours by distance, as gather_neighbors keeps them
+                    size_t count = 0;
+                    crowd.spatial.map_over_all_objects_in_locality(
+                        self._position.x,
+                        self._position.y,
+                        range,
+                        [&](lq::SpatialDatabase::Proxy* proxy, float dist_sq)
+                        {
+                            const Agent* other = static_cast<const Agent*>(proxy);
+                            if (other == &self)
+                                return;
+
+                            size_t at = count;
+                            if (count == Avoidance::MaxNeighbors)
+                            {
+                                if (dist_sq >= distance[count - 1])
+                                    return;
+                                --at;
+                            }
+                            else
+                            {
+                                ++count;
+                            }
+
+                            for (; at > 0 && distance[at - 1] > dist_sq; --at)
+                            {
+                                distance[at]  = distance[at - 1];
+                                neighbors[at] = neighbors[at - 1];
+                            }
+                            distance[at]  = dist_sq;
+                            neighbors[at] = {other->_position, other->velocity, other->radius};
+                        });
+
+                    Vec2f preferred = self.goal - self._position;
+                    if (preferred.length() > MaxSpeed)
+                        preferred = preferred.normalized() * MaxSpeed;
+
+                    crowd.solved[n] = Avoidance::computeVelocity({self._position, self.velocity, self.radius},
+                                                                 preferred,
+                                                                 MaxSpeed,
+                                                                 {neighbors, count},
+                                                                 crowd.time_horizon,
+                                                                 dt);
+                }
+            });
+
+        for (size_t n = 0; n < crowd.agents.size(); ++n)
+        {
+            auto& a     = crowd.agents[n];
+            a.velocity  = crowd.solved[n];
+            a._position += a.velocity * dt;
+            a._bbox     = Regionf(a._position.x - a.radius, a._position.y - a.radius, a._position.x + a.radius, a._position.y + a.radius);
+            crowd.spatial.update_for_new_location(&a);
+        }
+    }
+
+    void RunAvoidance()
+    {
+        const float dt = 1.f / 60.f;
+        for (int32_t count : {1000, 5000, 10000})
+        {
+            Crowd crowd;
+            Setup(crowd, count);
+
+            // Walk a while first so agents are moving and crowding when measured
+            for (int32_t n = 0; n < 60; ++n)
+                Step(crowd, dt);
+
+            bench::Report("one frame, agents", count, bench::Measure(20, [&] { Step(crowd, dt); }));
+        }
+    }
+} // namespace
+
+FINITE_BENCH("avoidance", RunAvoidance);
@@ -0,0 +1,21 @@
+// Headless benchmarks of engine hot paths, enabled with FINITE_BUILD_BENCH.
+// Usage: finite_bench [filter], runs every case whose name contains filter.
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+    auto&       cases  = bench::Cases();
+    std::sort(cases.begin(), cases.end(), [](const bench::Case& a, const bench::Case& b) { return std::strcmp(a.name, b.name) < 0; });
+    for (auto& c : cases)
+    {
+        if (!std::strstr(c.name, filter))
+            continue;
+        std::printf("%s\n", c.name);
+        c.run();
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+// lq::SpatialDatabase with 100k objects, radius and rect queries and moving a tenth of the objects,
+// for both the linked list bins and the grid storage.
+#include <climits>
+#include <functional>
+#include <tuple>
+
+#include "bench.hpp"
+
+// math_utils.hpp relies on include.hpp for the standard headers above.
+#include "utils/lquery.hpp"
+
+#include <random>
+
+using namespace fin;
+
+namespace
+{
+    constexpr int32_t ObjectCount = 100000;
+    constexpr float   WorldSize   = 20480.f;
+
+    using Proxy = lq::SpatialDatabase::Proxy;
+
+    struct Query
+    {
+        Vec2f pos;
+        float radius;
+        Rectf rect;
+    };
+
+    void Place(lq::SpatialDatabase& db, Proxy& obj, Vec2f pos)
+    {
+        obj._position = pos;
+        obj._bbox     = Regionf(pos.x - 16, pos.y - 48, pos.x + 16, pos.y);
+        db.update_for_new_location(&obj);
+    }
+
+    void RunStorage(const char* name, lq::SpatialDatabase& db, const std::vector<Vec2f>& places, const std::vector<Query>& queries)
+    {
+        std::vector<Proxy> objects(ObjectCount);
+        for (int32_t n = 0; n < ObjectCount; ++n)
+            Place(db, objects[n], places[n]);
+
+        std::printf(" %s\n", name);
+
+        size_t found = 0;
+        bench::Report("radius queries", int32_t(queries.size()), bench::Measure(5, [&] {
+            for (auto& q : queries)
+                db.map_over_all_objects_in_locality(q.pos.x, q.pos.y, q.radius, [&](Proxy*, float) { ++found; });
+        }));
+        bench::Report("rect queries", int32_t(queries.size()), bench::Measure(5, [&] {
+            for (auto& q : queries)
+                db.map_over_all_objects_in_locality(q.rect, [&](Proxy*) { ++found; });
+        }));
+
+        // A tenth of the objects walk a few units each frame
+        uint32_t frame = 0;
+        bench::Report("move objects", ObjectCount / 10, bench::Measure(5, [&] {
+            const float step = (++frame & 1) ? 4.f : -4.f;
+            for (int32_t n = 0; n < ObjectCount; n += 10)
+                Place(db, objects[n], objects[n]._position + Vec2f(step, step));
+        }));
+
+        for (auto& obj : objects)
+            db.remove_from_bin(&obj);
+        if (!found)
+            std::printf("  no results\n");
+    }
+
+    void RunSpatial()
+    {
+        std::mt19937                          rng(5);
+        std::uniform_real_distribution<float> pos(0, WorldSize);
+        std::uniform_real_distribution<float> radius(50, 350);
+        std::uniform_real_distribution<float> extent(100, 1500);
+
+        std::vector<Vec2f> places(ObjectCount);
+        for (auto& p : places)
+            p = Vec2f(pos(rng), pos(rng));
+
+        std::vector<Query> queries(10000);
+        for (auto& q : queries)
+        {
+            q.pos    = Vec2f(pos(rng), pos(rng));
+            q.radius = radius(rng);
+            q.rect   = Rectf(q.pos.x, q.pos.y, extent(rng), extent(rng) * 0.6f);
+        }
+
+        const Rectf world(0, 0, WorldSize, WorldSize);
+
+        lq::SpatialDatabase lists;
+        lists.init(world, 40, 40);
+        RunStorage("lists, 512 unit bins", lists, places, queries);
+
+        lq::SpatialDatabase grid;
+        grid.init_grid(world, 128.f);
+        RunStorage("grid, 128 unit cells", grid, places, queries);
+    }
+} // namespace
+
+FINITE_BENCH("spatial", RunSpatial);
@@ -0,0 +1,71 @@
+// Triangulator on 10k vertex region polygons, a noisy ring and a comb where half the vertices are reflex.
+#include <climits>
+#include <functional>
+#include <tuple>
+
+#include "bench.hpp"
+
+// math_utils.hpp relies on include.hpp for the standard headers above.
+#include "utils/triangulate.hpp"
+
+#include <random>
+
+using namespace fin;
+
+namespace
+{
+    constexpr int32_t VertexCount = 10000;
+
+    std::vector<Vec2f> MakeRing()
+    {
+        std::mt19937                          rng(3);
+        std::uniform_real_distribution<float> noise(0.3f, 1.f);
+
+        std::vector<Vec2f> poly;
+        for (int32_t n = 0; n < VertexCount; ++n)
+        {
+            const float t = 6.2831853f * n / VertexCount;
+            const float r = 4000 * noise(rng) * (1 + 0.5f * std::sin(t * 37));
+            poly.emplace_back(r * std::cos(t), r * std::sin(t));
+        }
+        return poly;
+    }
+
+    std::vector<Vec2f> MakeComb()
+    {
+        // Teeth along the top, closed by the two bottom corners
+        const int32_t teeth = (VertexCount - 2) / 2;
+
+        std::vector<Vec2f> poly;
+        for (int32_t n = 0; n < teeth; ++n)
+        {
+            poly.emplace_back(n * 8.f, 0.f);
+            poly.emplace_back(n * 8.f + 4, 200.f);
+        }
+        poly.emplace_back(teeth * 8.f, 300.f);
+        poly.emplace_back(0.f, 300.f);
+        return poly;
+    }
+
+    void RunShape(const char* name, const std::vector<Vec2f>& poly)
+    {
+        Triangulator       tri;
+        std::vector<Vec2f> out;
+        const double       ms = bench::Measure(5, [&] {
+            out.clear();
+            tri.run(poly, out);
+        });
+
+        bench::Report(name, int32_t(poly.size()), ms);
+        if (out.size() != (poly.size() - 2) * 3)
+            std::printf("  %s: %zu triangles, expected %zu\n", name, out.size() / 3, poly.size() - 2);
+    }
+
+    void RunTriangulate()
+    {
+        RunShape("noisy ring, vertices", MakeRing());
+        RunShape("comb, vertices", MakeComb());
+    }
+} // namespace
+
+FINITE_BENCH("triangulate", RunTriangulate);
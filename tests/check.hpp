@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertion for the headless checks, reports and keeps going so one run shows every failure.
+inline int g_check_failures = 0;
+
+#define CHECK(expr)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if (!(expr))                                                                 \
+        {                                                                            \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr);    \
+            ++g_check_failures;                                                      \
+        }                                                                            \
+    } while (0)
+
+inline int CheckResult()
+{
+    std::printf(g_check_failures ? "%d checks failed\n" : "ok\n", g_check_failures);
+    return g_check_failures ? 1 : 0;
+}
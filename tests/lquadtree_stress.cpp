@@ -0,0 +1,115 @@
+// Fills a LooseQuadTree with a million sprites and checks queries against brute force,
+// before and after removing some of them. Usage: lquadtree_stress [count]
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <tuple>
+#include <vector>
+
+// math_utils.hpp relies on include.hpp for the standard headers above.
+#include "utils/lquadtree.hpp"
+
+using namespace fin;
+
+namespace
+{
+    struct Sprite
+    {
+        Rectf    _bbox;
+        uint32_t _index;
+
+        bool operator==(const Sprite& other) const
+        {
+            return this == &other;
+        }
+    };
+
+    struct SpriteBounds
+    {
+        const Rectf& operator()(const Sprite& s) const
+        {
+            return s._bbox;
+        }
+    };
+
+    using Tree = LooseQuadTree<Sprite, SpriteBounds>;
+
+    double Elapsed(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    bool Check(Tree& tree, const Rectf& area, const char* what)
+    {
+        std::vector<int32_t> expected;
+        for (int32_t n = 0; n < tree.size(); ++n)
+        {
+            if (!tree.is_empty(n) && tree[n]._bbox.intersects(area))
+                expected.push_back(n);
+        }
+
+        tree.activate(area);
+        std::vector<int32_t> found(tree.get_active().begin(), tree.get_active().end());
+        std::sort(found.begin(), found.end());
+        if (found != expected)
+        {
+            std::printf("FAIL %s: found %zu, brute force %zu\n", what, found.size(), expected.size());
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int32_t count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const float   world = 65536.f;
+
+    Tree                                  tree({0, 0, world, world});
+    std::mt19937                          rng(1);
+    std::uniform_real_distribution<float> pos(0, world - 64);
+    std::uniform_real_distribution<float> size(8, 64);
+
+    auto                 start = std::chrono::steady_clock::now();
+    std::vector<int32_t> ids;
+    ids.reserve(count);
+    for (int32_t i = 0; i < count; ++i)
+        ids.push_back(tree.insert(Sprite{{pos(rng), pos(rng), size(rng), size(rng)}, uint32_t(i)}));
+    std::printf("insert %d: %.1f ms\n", count, Elapsed(start));
+
+    // Chunked storage must keep references stable while the tree grows.
+    const Sprite* first = &tree[ids[0]];
+    for (int32_t i = 0; i < 1000; ++i)
+        tree.insert(Sprite{{pos(rng), pos(rng), 32, 32}, 0});
+    if (first != &tree[ids[0]] || first->_index != 0)
+    {
+        std::printf("FAIL reference moved on growth\n");
+        return 1;
+    }
+
+    const Rectf areas[] = {{1000, 1000, 1920, 1080}, {30000, 12000, 4096, 4096}, {0, 0, world, 512}};
+    bool        ok      = true;
+    start               = std::chrono::steady_clock::now();
+    for (auto& area : areas)
+        ok &= Check(tree, area, "full tree");
+    std::printf("query: %.1f ms\n", Elapsed(start));
+
+    // Removal walks every node the bounds touch, a sample keeps the run short.
+    start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < count; i += 32)
+        tree.remove(tree[ids[i]]);
+    std::printf("remove %d: %.1f ms\n", (count + 31) / 32, Elapsed(start));
+    for (auto& area : areas)
+        ok &= Check(tree, area, "after remove");
+
+    // Objects outside the world bounds live in the outside list.
+    tree.insert(Sprite{{-100, -100, 50, 50}, 0});
+    ok &= Check(tree, {-200, -200, 400, 400}, "outside world");
+
+    std::printf(ok ? "ok\n" : "failed\n");
+    return ok ? 0 : 1;
+}
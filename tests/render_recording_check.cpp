@@ -0,0 +1,280 @@
+// Records sprite sequences through Renderer into a RecordingBackend and checks that batching merges
+// consecutive sprites of one texture without reordering them, then rasterizes a small list with the
+// SoftwareBackend and compares pixels. Needs no GL context.
+#include "core/renderer.hpp"
+#include "core/software_backend.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "check.hpp"
+
+using namespace fin;
+
+namespace
+{
+    struct Sprite
+    {
+        const Texture* texture;
+        Vec2f          pos; // iso cell
+    };
+
+    Texture MakeTexture(uint32_t id)
+    {
+        Texture txt{};
+        txt.id     = id;
+        txt.width  = 256;
+        txt.height = 256;
+        return txt;
+    }
+
+    Rectf IsoDest(Vec2f cell)
+    {
+        return {(cell.x - cell.y) * 32.f, (cell.x + cell.y) * 16.f, 64, 64};
+    }
+
+    void CheckIsoSequence()
+    {
+        const Texture atlas[] = {MakeTexture(1), MakeTexture(2), MakeTexture(3)};
+
+        // Objects on an iso grid, textures mostly shared along depth bands with a few odd ones out.
+        std::mt19937        rng(7);
+        std::vector<Sprite> sprites;
+        for (int32_t y = 0; y < 80; ++y)
+        {
+            for (int32_t x = 0; x < 80; ++x)
+                sprites.push_back({&atlas[((x + y) / 8 + (rng() % 8 == 0)) % 3], Vec2f(float(x), float(y))});
+        }
+
+        // Back to front as ObjectSceneLayer orders them, by depth then by x.
+        std::sort(sprites.begin(),
+                  sprites.end(),
+                  [](const Sprite& a, const Sprite& b)
+                  {
+                      const float da = a.pos.x + a.pos.y, db = b.pos.x + b.pos.y;
+                      return da != db ? da < db : a.pos.x < b.pos.x;
+                  });
+
+        // Expected batches are the runs of one texture in that order.
+        std::vector<uint32_t> runs;
+        for (auto& s : sprites)
+        {
+            if (runs.empty() || runs.back() != s.texture->id)
+                runs.push_back(s.texture->id);
+        }
+
+        Renderer         dc;
+        RecordingBackend rec(true);
+        dc.set_backend(&rec);
+        for (auto& s : sprites)
+            dc.render_texture(s.texture, {0, 0, 64, 64}, IsoDest(s.pos));
+
+        auto cmds = dc.get_commands().commands();
+        CHECK(cmds.size() == runs.size());
+        CHECK(cmds.size() < sprites.size() / 4);
+
+        // Commands keep the order, vertices are contiguous and every quad sits at its sprite.
+        size_t   n    = 0;
+        uint32_t next = 0;
+        for (size_t c = 0; c < cmds.size() && c < runs.size(); ++c)
+        {
+            CHECK(cmds[c].op == RenderOp::Quads && cmds[c].texture == runs[c]);
+            CHECK(cmds[c].first == next && cmds[c].count % 4 == 0);
+            next += cmds[c].count;
+            for (uint32_t v = cmds[c].first; v < cmds[c].first + cmds[c].count && n < sprites.size(); v += 4, ++n)
+            {
+                const auto& vtx  = dc.get_commands().vertices()[v];
+                const Rectf dest = IsoDest(sprites[n].pos);
+                CHECK(sprites[n].texture->id == cmds[c].texture && vtx.x == dest.x && vtx.y == dest.y);
+            }
+        }
+        CHECK(n == sprites.size());
+
+        dc.flush();
+        CHECK(dc.get_commands().empty());
+        CHECK(dc.draw_calls() == runs.size());
+        CHECK(rec.stats().draw_calls == runs.size());
+        CHECK(rec.stats().quads == sprites.size());
+        CHECK(rec.commands().size() == runs.size());
+
+        dc.reset_stats();
+        CHECK(dc.draw_calls() == 0);
+    }
+
+    void CheckBatchBreaks()
+    {
+        const Texture a = MakeTexture(1), b = MakeTexture(2);
+
+        Renderer         dc;
+        RecordingBackend rec;
+        dc.set_backend(&rec);
+
+        // One texture splits only when a command is full.
+        const uint32_t per_command = 4096; // CommandList::MaxVertices / 4
+        for (uint32_t i = 0; i < per_command * 2 + 10; ++i)
+            dc.render_texture(&a, {0, 0, 16, 16}, {float(i), 0, 16, 16});
+        CHECK(dc.get_commands().commands().size() == 3);
+        dc.flush();
+        CHECK(rec.stats().draw_calls == 3 && rec.stats().quads == per_command * 2 + 10);
+
+        // Other primitives and texture changes break the batch, shaders are state and cost no draw call.
+        rec.reset();
+        dc.reset_stats();
+        dc.render_texture(&a, {0, 0, 16, 16}, {0, 0, 16, 16});
+        dc.render_texture(&a, {0, 0, 16, 16}, {16, 0, 16, 16});
+        dc.render_line({0, 0}, {10, 10});
+        dc.render_line({0, 0}, {10, 10});
+        dc.render_texture(&a, {0, 0, 16, 16}, {0, 0, 16, 16});
+        dc.render_texture(&b, {0, 0, 16, 16}, {0, 0, 16, 16});
+        dc.render_rect({0, 0, 4, 4});
+        dc.render_triangle({0, 0}, {1, 0}, {0, 1});
+        dc.get_commands().set_shader(nullptr);
+        dc.render_debug_text({0, 0}, "%d", 1);
+        dc.flush();
+
+        const auto& stats = rec.stats();
+        CHECK(stats.draw_calls == 7);
+        CHECK(stats.quads == 5 && stats.lines == 2 && stats.triangles == 1);
+        CHECK(stats.texts == 1 && stats.shaders == 1);
+        CHECK(dc.draw_calls() == 8); // counts commands including the shader change
+    }
+
+    void CheckAppend()
+    {
+        const Texture a = MakeTexture(1);
+
+        // Renderers recording in parallel append in order and merge across the seam.
+        Renderer         dc, part0, part1;
+        RecordingBackend rec(true);
+        dc.set_backend(&rec);
+        part0.inherit(dc);
+        part1.inherit(dc);
+        part0.render_texture(&a, {0, 0, 16, 16}, {0, 0, 16, 16});
+        part1.render_texture(&a, {0, 0, 16, 16}, {16, 0, 16, 16});
+        part1.render_line({0, 0}, {1, 1});
+        dc.render_texture(&a, {0, 0, 16, 16}, {32, 0, 16, 16});
+        dc.append(part0);
+        dc.append(part1);
+        CHECK(part0.get_commands().empty() && part1.get_commands().empty());
+        dc.flush();
+
+        auto cmds = rec.commands();
+        CHECK(cmds.size() == 2);
+        CHECK(cmds.size() == 2 && cmds[0].op == RenderOp::Quads && cmds[0].count == 12 && cmds[1].op == RenderOp::Lines);
+    }
+    void CheckCommandList()
+    {
+        // Items referenced by index are rebased when lists are appended.
+        StaticGeometry geo;
+        GeometryBuffer buffer;
+        auto*          shader = reinterpret_cast<Shader2D*>(&geo); // only compared, never bound
+
+        CommandList head, tail;
+        head.add_text({1, 2}, "head", WHITE);
+        head.set_shader(nullptr);
+        tail.add_line({0, 0}, {1, 1}, RED);
+        tail.add_text({3, 4}, "tail", RED);
+        tail.add_geometry(buffer, geo, {0, 0, 10, 10}, WHITE);
+        tail.set_shader(shader);
+        head.append(tail);
+
+        auto cmds = head.commands();
+        CHECK(cmds.size() == 6);
+        if (cmds.size() != 6)
+            return;
+
+        CHECK(cmds[0].op == RenderOp::Text && std::string_view(head.text_string(head.text(cmds[0].first))) == "head");
+        CHECK(cmds[2].op == RenderOp::Lines && cmds[2].first == 0 && head.vertices()[1].x == 1.f);
+        CHECK(cmds[3].op == RenderOp::Text && std::string_view(head.text_string(head.text(cmds[3].first))) == "tail");
+        CHECK(head.text(cmds[3].first).pos.x == 3.f && head.text(cmds[3].first).color.r == RED.r);
+        CHECK(cmds[4].op == RenderOp::Geometry && head.geometry(cmds[4].first).geometry == &geo);
+        CHECK(head.geometry(cmds[4].first).view.width == 10.f);
+        CHECK(cmds[1].op == RenderOp::Shader && head.shader(cmds[1].first) == nullptr);
+        CHECK(cmds[5].op == RenderOp::Shader && head.shader(cmds[5].first) == shader);
+
+        // Geometry is counted as a command, the empty bake makes it draw nothing.
+        RecordingBackend rec;
+        rec.submit(head);
+        CHECK(rec.stats().geometry == 1 && rec.stats().texts == 2 && rec.stats().draw_calls == 4);
+
+        head.clear();
+        CHECK(head.empty() && head.vertices().empty());
+    }
+
+    bool SamePixel(Color a, Color b)
+    {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+
+    void CheckSoftwareRaster()
+    {
+        // 2x2 texture drawn at twice its size, texel rows top down
+        Color   texels[4] = {RED, GREEN, BLUE, WHITE};
+        Image   img{texels, 2, 2, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        Texture txt{};
+        txt.id     = 5;
+        txt.width  = 2;
+        txt.height = 2;
+
+        SoftwareBackend sw;
+        sw.begin(16, 16, BLACK);
+        sw.set_texture(txt.id, img);
+
+        Renderer dc;
+        dc.set_backend(&sw);
+        dc.set_color(RED);
+        dc.render_rect({0, 0, 4, 4});
+        dc.set_color(WHITE);
+        dc.render_texture(&txt, {0, 0, 2, 2}, {4, 0, 4, 4});
+        dc.set_color(GREEN);
+        dc.render_triangle({8, 0}, {16, 0}, {8, 8});
+        dc.set_color(BLUE);
+        dc.render_line({0, 10.5f}, {16, 10.5f});
+        dc.set_color(WHITE);
+        dc.render_rect({0, 12, 4, 4});
+        dc.set_color({255, 0, 0, 128});
+        dc.render_rect({2, 12, 4, 4});
+        dc.flush();
+
+        CHECK(sw.get_size().x == 16 && sw.get_size().y == 16);
+
+        // Solid quad, right and bottom edges exclusive
+        CHECK(SamePixel(sw.get_pixel(0, 0), RED) && SamePixel(sw.get_pixel(3, 3), RED));
+        CHECK(SamePixel(sw.get_pixel(0, 4), BLACK));
+
+        // Textured quad, nearest sampling
+        CHECK(SamePixel(sw.get_pixel(4, 0), RED) && SamePixel(sw.get_pixel(5, 1), RED));
+        CHECK(SamePixel(sw.get_pixel(6, 0), GREEN) && SamePixel(sw.get_pixel(4, 2), BLUE));
+        CHECK(SamePixel(sw.get_pixel(7, 3), WHITE));
+
+        // Triangle, inside and past the hypotenuse
+        CHECK(SamePixel(sw.get_pixel(9, 1), GREEN) && SamePixel(sw.get_pixel(8, 6), GREEN));
+        CHECK(SamePixel(sw.get_pixel(15, 7), BLACK));
+
+        // Line, one pixel wide over the whole row
+        CHECK(SamePixel(sw.get_pixel(0, 10), BLUE) && SamePixel(sw.get_pixel(15, 10), BLUE));
+        CHECK(SamePixel(sw.get_pixel(7, 9), BLACK) && SamePixel(sw.get_pixel(7, 11), BLACK));
+
+        // Half transparent red over white and over black, alpha accumulates towards opaque
+        CHECK(SamePixel(sw.get_pixel(1, 13), WHITE));
+        CHECK(SamePixel(sw.get_pixel(3, 13), {255, 127, 127, 255}));
+        CHECK(SamePixel(sw.get_pixel(5, 13), {128, 0, 0, 255}));
+        CHECK(SamePixel(sw.get_pixel(6, 13), BLACK));
+
+        // Unregistered textures are skipped, submitting again keeps the target
+        txt.id = 6;
+        dc.render_texture(&txt, {0, 0, 2, 2}, {0, 0, 16, 16});
+        dc.flush();
+        CHECK(SamePixel(sw.get_pixel(0, 0), RED) && SamePixel(sw.get_pixel(15, 15), BLACK));
+    }
+} // namespace
+
+int main()
+{
+    CheckIsoSequence();
+    CheckBatchBreaks();
+    CheckAppend();
+    CheckCommandList();
+    CheckSoftwareRaster();
+    return CheckResult();
+}
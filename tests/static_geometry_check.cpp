@@ -0,0 +1,183 @@
+// Bakes known quads and triangles into StaticGeometry and checks chunks, batches and indices,
+// in particular that reading the chunks in order gives back the order the shapes were added in.
+#include <climits>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+// math_utils.hpp relies on include.hpp for the standard headers above.
+#include "utils/static_geometry.hpp"
+
+#include "check.hpp"
+
+using namespace fin;
+
+namespace
+{
+    const uint8_t White[4]{255, 255, 255, 255};
+    const Regionf FullUv(0, 0, 1, 1);
+
+    bool SameBatch(const GeometryBatch& batch, uint32_t texture, uint32_t first, uint32_t count)
+    {
+        return batch.texture == texture && batch.first == first && batch.count == count;
+    }
+
+    void CheckQuadOrder()
+    {
+        // Three quads per chunk. Positions jump around so a spatial split would reorder them.
+        struct Quad
+        {
+            uint32_t texture;
+            float    x, y;
+        };
+        const Quad quads[] = {{1, 900, 900}, {1, 0, 0}, {2, 500, 0}, {2, 0, 900}, {2, 900, 0}, {1, 10, 10}, {1, 950, 950}};
+
+        StaticGeometry geo;
+        geo.begin(12);
+        for (auto& q : quads)
+            geo.add_quad(q.texture, Regionf(q.x, q.y, q.x + 32, q.y + 32), FullUv, White);
+        geo.end();
+
+        auto chunks = geo.chunks();
+        // Chunks read in order give back the quads in the order they were added.
+        size_t n = 0;
+        for (auto& chunk : chunks)
+        {
+            for (size_t v = 0; v < chunk.vertices.size(); v += 4, ++n)
+            {
+                CHECK(n < std::size(quads));
+                if (n >= std::size(quads))
+                    break;
+                CHECK(chunk.vertices[v].x == quads[n].x && chunk.vertices[v].y == quads[n].y);
+                CHECK(chunk.vertices[v + 2].x == quads[n].x + 32 && chunk.vertices[v + 2].u == 1.f);
+            }
+        }
+        CHECK(n == std::size(quads));
+
+        CHECK(chunks.size() == 3);
+        if (chunks.size() != 3)
+            return;
+
+        CHECK(chunks[0].vertices.size() == 12 && chunks[1].vertices.size() == 12 && chunks[2].vertices.size() == 4);
+        CHECK(chunks[0].batches.size() == 2);
+        CHECK(SameBatch(chunks[0].batches[0], 1, 0, 12));
+        CHECK(SameBatch(chunks[0].batches[1], 2, 12, 6));
+        CHECK(chunks[1].batches.size() == 2);
+        CHECK(SameBatch(chunks[1].batches[0], 2, 0, 12));
+        CHECK(SameBatch(chunks[1].batches[1], 1, 12, 6));
+        CHECK(chunks[2].batches.size() == 1);
+        CHECK(SameBatch(chunks[2].batches[0], 1, 0, 6));
+
+        // Each quad is two triangles over its own four vertices.
+        const std::vector<uint16_t> quad_indices{0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7, 8, 9, 10, 8, 10, 11};
+        CHECK(chunks[0].indices == quad_indices);
+        CHECK(chunks[1].indices == quad_indices);
+
+        CHECK(chunks[0].bounds.x1 == 0 && chunks[0].bounds.y1 == 0 && chunks[0].bounds.x2 == 932 && chunks[0].bounds.y2 == 932);
+
+        // Culling keeps draw order and skips chunks whose shapes are all outside the view.
+        std::vector<const GeometryChunk*> visible;
+        geo.query(Rectf(940, 940, 100, 100), visible);
+        CHECK(visible.size() == 1 && visible[0] == &chunks[2]);
+        geo.query(Rectf(0, 0, 1000, 1000), visible);
+        CHECK(visible.size() == 3 && visible[0] == &chunks[0] && visible[2] == &chunks[2]);
+    }
+
+    void CheckTriangles()
+    {
+        std::vector<Vec2f> points;
+        for (int i = 0; i < 10; ++i)
+        {
+            const float x = float(i) * 10;
+            points.insert(points.end(), {{x, 0}, {x, 10}, {x + 10, 10}});
+        }
+        points.emplace_back(0, 0); // incomplete triangle is dropped
+
+        StaticGeometry geo;
+        geo.begin(12);
+        geo.add_quad(1, Regionf(0, 0, 8, 8), FullUv, White);
+        geo.add_triangles(2, points, {0, 0}, {0.5f, 0.25f}, White);
+        geo.add_triangles(2, std::span(points).first(2), {0, 0}, {1, 1}, White);
+        geo.add_quad(3, Regionf(0, 0, 8, 8), FullUv, White);
+        geo.end();
+
+        // The quad fills the first chunk partly, the triangles continue in chunks of 12 vertices
+        // and the last quad joins the remaining 6.
+        auto chunks = geo.chunks();
+        CHECK(chunks.size() == 4);
+        if (chunks.size() != 4)
+            return;
+
+        CHECK(chunks[0].vertices.size() == 4);
+        CHECK(chunks[1].vertices.size() == 12 && chunks[2].vertices.size() == 12);
+        CHECK(chunks[3].vertices.size() == 10);
+        CHECK(chunks[1].batches.size() == 1 && SameBatch(chunks[1].batches[0], 2, 0, 12));
+        CHECK(chunks[3].batches.size() == 2);
+        CHECK(SameBatch(chunks[3].batches[0], 2, 0, 6));
+        CHECK(SameBatch(chunks[3].batches[1], 3, 6, 6));
+
+        const std::vector<uint16_t> tri_indices{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+        CHECK(chunks[2].indices == tri_indices);
+        CHECK(chunks[3].indices == std::vector<uint16_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 6, 8, 9}));
+
+        // Points come out in order with uv from origin and scale.
+        size_t n = 0;
+        for (size_t c = 1; c < 4; ++c)
+        {
+            for (size_t v = 0; v < chunks[c].vertices.size() && n < 30; ++v, ++n)
+            {
+                auto& vtx = chunks[c].vertices[v];
+                CHECK(vtx.x == points[n].x && vtx.y == points[n].y);
+                CHECK(vtx.u == points[n].x * 0.5f && vtx.v == points[n].y * 0.25f);
+            }
+        }
+        CHECK(n == 30);
+    }
+
+    void CheckIndexLimit()
+    {
+        // The default chunk size stays within 16 bit indices.
+        StaticGeometry geo;
+        geo.begin();
+        for (int i = 0; i < 20000; ++i)
+            geo.add_quad(1, Regionf(float(i), 0, float(i) + 1, 1), FullUv, White);
+        geo.end();
+
+        auto chunks = geo.chunks();
+        CHECK(chunks.size() == 2);
+        size_t quads = 0;
+        for (auto& chunk : chunks)
+        {
+            CHECK(chunk.vertices.size() <= StaticGeometry::MaxVertices);
+            uint16_t top = 0;
+            for (auto i : chunk.indices)
+                top = std::max(top, i);
+            CHECK(top < chunk.vertices.size());
+            quads += chunk.vertices.size() / 4;
+        }
+        CHECK(quads == 20000);
+    }
+
+    void CheckRevision()
+    {
+        StaticGeometry geo;
+        const auto     rev = geo.revision();
+        geo.begin(1); // clamped to a whole quad and triangle
+        geo.add_quad(1, Regionf(0, 0, 1, 1), FullUv, White);
+        geo.add_quad(1, Regionf(0, 0, 1, 1), FullUv, White);
+        geo.end();
+        CHECK(geo.revision() == rev + 1);
+        CHECK(geo.chunks().size() == 1);
+        geo.clear();
+        CHECK(geo.empty() && geo.revision() == rev + 2);
+    }
+} // namespace
+
+int main()
+{
+    CheckQuadOrder();
+    CheckTriangles();
+    CheckIndexLimit();
+    CheckRevision();
+    return CheckResult();
+}